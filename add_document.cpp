@@ -6,6 +6,9 @@
 #include <map>
 #include <sstream>
 #include "common.h"
+#include "date_format.h"
+#include "lexicon_format.h"
+#include "metadata_format.h"
 #include <cstdint>
 
 using namespace std;
@@ -15,6 +18,9 @@ const string LEXICON_FILE = "C:\\Users\\Hank47\\Sem3\\Rummager\\lexicon.bin";
 const string LENGTHS_FILE = "C:\\Users\\Hank47\\Sem3\\Rummager\\doc_lengths.bin";
 const string FORWARD_FILE = "C:\\Users\\Hank47\\Sem3\\Rummager\\forward_index.bin";
 const string META_FILE    = "C:\\Users\\Hank47\\Sem3\\Rummager\\doc_metadata.txt";
+const string POSITIONS_FILE = "C:\\Users\\Hank47\\Sem3\\Rummager\\forward_positions.bin";
+const string DATES_FILE = "C:\\Users\\Hank47\\Sem3\\Rummager\\doc_dates.bin";
+const string META_STORE_FILE = "C:\\Users\\Hank47\\Sem3\\Rummager\\doc_metadata.bin";
 
 // Helper to get file content
 string readFile(const string& path) {
@@ -42,62 +48,65 @@ int main(int argc, char* argv[]) {
 
     // 1. LOAD LEXICON
     cout << "Loading Lexicon..." << endl;
-    unordered_map<string, int> lexicon;
-    fstream lexFile(LEXICON_FILE, ios::binary | ios::in | ios::out); // in/out for update
-    if (!lexFile) {
+    LexiconView lexicon;
+    if (!lexicon.open(LEXICON_FILE)) {
         cerr << "Error: lexicon.bin not found!" << endl;
         return 1;
     }
 
-    uint32_t totalWords;
-    lexFile.read((char*)&totalWords, sizeof(totalWords));
-    uint32_t originalTotalWords = totalWords;
-
-    // Read all existing words
-    for (uint32_t i = 0; i < totalWords; i++) {
-        uint32_t len;
-        lexFile.read((char*)&len, sizeof(len));
-        string word(len, ' ');
-        lexFile.read(&word[0], len);
-        lexicon[word] = i; 
+    // v2 has no room to append in place: keep everything per word and
+    // write the lexicon (new perfect hash included) back once at the end
+    vector<string> words = lexicon.words();
+    vector<uint32_t> docFreq(words.size());
+    vector<uint64_t> listOffsets(words.size());
+    for (uint32_t i = 0; i < words.size(); i++) {
+        docFreq[i] = lexicon.df(i);
+        listOffsets[i] = lexicon.listOffset(i);
     }
+    unordered_map<string, int> newWords;
 
     // 2. TOKENIZE & IDENTIFY NEW WORDS
-    vector<string> tokens = Tokenize::tokenize(content);
+    Tokenizer tokenizer;
+    const vector<string_view>& tokens = tokenizer.tokenize(content);
     map<int, int> docWordFreq;
+    map<int, vector<uint32_t>> docWordPositions; // Kept in sync with forward_positions.bin (if present)
     int totalWordsInDoc = 0;
     int newWordsCount = 0;
 
-    // We must go to the end of the lexFile to append new words
-    lexFile.seekp(0, ios::end); 
-
-    for (const string& token : tokens) {
-        int id;
-        if (lexicon.find(token) == lexicon.end()) {
-            // NEW WORD
-            id = totalWords++; 
-            lexicon[token] = id;
-            newWordsCount++;
-            
-            // Append to Lexicon File immediately
-            uint32_t len = (uint32_t)token.length();
-            lexFile.write((char*)&len, sizeof(len));
-            lexFile.write(token.c_str(), len);
-        } else {
-            id = lexicon[token];
+    for (size_t t = 0; t < tokens.size(); ++t) {
+        string_view view = tokens[t];
+        int id = lexicon.find(view.data(), view.size());
+        if (id == -1) {
+            string token(view);
+            auto it = newWords.find(token);
+            if (it == newWords.end()) {
+                // NEW WORD (no posting list until create_barrels runs again)
+                id = (int)words.size();
+                newWords.emplace(token, id);
+                words.push_back(token);
+                docFreq.push_back(0);
+                listOffsets.push_back(NO_LIST_OFFSET);
+                newWordsCount++;
+            } else {
+                id = it->second;
+            }
         }
         
         docWordFreq[id]++;
+        docWordPositions[id].push_back((uint32_t)t);
         totalWordsInDoc++;
     }
 
-    // Update Lexicon Header if changed
+    // Write the lexicon back (df counts this doc too)
+    lexicon.close();
+    for (const auto& entry : docWordFreq) docFreq[entry.first]++;
+    if (!writeLexicon(LEXICON_FILE, words, docFreq, listOffsets)) {
+        cerr << "Error: could not write lexicon.bin!" << endl;
+        return 1;
+    }
     if (newWordsCount > 0) {
-        lexFile.seekp(0, ios::beg);
-        lexFile.write((char*)&totalWords, sizeof(totalWords)); // New Count
         cout << "Added " << newWordsCount << " new words to Lexicon." << endl;
     }
-    lexFile.close();
 
     // 3. DETERMINE NEW DOC ID & UPDATE LENGTHS
     fstream lenFile(LENGTHS_FILE, ios::binary | ios::in | ios::out);
@@ -146,6 +155,19 @@ int main(int argc, char* argv[]) {
     }
     fwdFile.close();
 
+    // 4b. APPEND POSITIONS (only if the index was built with --positions)
+    ifstream posCheck(POSITIONS_FILE, ios::binary);
+    if (posCheck) {
+        posCheck.close();
+        ofstream posFile(POSITIONS_FILE, ios::binary | ios::app);
+        posFile.write((char*)&uDocID, sizeof(uDocID));
+        posFile.write((char*)&uTotal, sizeof(uTotal));
+        for (const auto& pair : docWordPositions) {
+            posFile.write((char*)pair.second.data(), pair.second.size() * sizeof(uint32_t));
+        }
+        posFile.close();
+    }
+
     // 5. UPDATE METADATA
     fstream metaFile(META_FILE, ios::in | ios::out | ios::ate); // Read/Write, Start at End
     if (metaFile) {
@@ -197,9 +219,30 @@ int main(int argc, char* argv[]) {
         
         // So output must be:
         metaFile << originalID << "|" << title << "|" << authors << "|" << category << "|" << date << endl;
+
+        // 5b. DATE COLUMN (if create_barrels built one and it is up to date)
+        fstream dateFile(DATES_FILE, ios::binary | ios::in | ios::out);
+        uint32_t numDates = 0;
+        if (dateFile && dateFile.read((char*)&numDates, sizeof(numDates)) && numDates == newDocID) {
+            numDates++;
+            dateFile.seekp(0, ios::beg);
+            dateFile.write((char*)&numDates, sizeof(numDates));
+            dateFile.seekp(0, ios::end);
+            uint32_t day = dayOrNone(date);
+            dateFile.write((char*)&day, sizeof(day));
+        }
+        dateFile.close();
     }
     metaFile.close();
 
+    // 5c. METADATA STORE (if create_barrels built one): columns can't grow in
+    // place, so it is rebuilt from the updated text
+    if (ifstream(META_STORE_FILE, ios::binary)) {
+        if (!writeMetadataStore(META_STORE_FILE, buildMetadataStore(META_FILE))) {
+            cerr << "Warning: could not rebuild doc_metadata.bin (the engine rebuilds it at load)." << endl;
+        }
+    }
+
     cout << "Success! Document added." << endl;
 
     return 0;
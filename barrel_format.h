@@ -0,0 +1,361 @@
+#ifndef BARREL_FORMAT_H
+#define BARREL_FORMAT_H
+
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+#include <algorithm>
+#include <cmath>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    #define BARREL_HAVE_X86_SIMD 1
+    #include <immintrin.h>
+#endif
+
+using namespace std;
+
+// ---------------------------------------------------------
+// BARREL FORMAT v2 (Compressed, Block-Based)
+// ---------------------------------------------------------
+// v1 (legacy): [Offset Table: long long x WORDS_PER_BARREL]
+//              [ListSize][Posting{docID,freq}]...   (8 bytes per posting)
+//
+// v2/v3:       [BarrelHeader]   (v2 ends before staticDocs)
+//              [Offset Table: uint64 x wordsPerBarrel]   (0 = no postings)
+//              per list (4-byte aligned):
+//                [ListHeader{count, numBlocks}]
+//                [BlockEntry{lastDocID, byteOffset} x numBlocks]   <- skip data
+//                [BlockBound{maxTermScore, maxPageRank} x numBlocks] <- only if BARREL_FLAG_BLOCK_MAX
+//                [Block 0][Block 1]...[16 bytes padding]
+//
+// A block holds up to POSTING_BLOCK_SIZE postings as two StreamVByte streams:
+//   docID gaps (delta vs. the previous block's lastDocID), then raw freqs.
+// StreamVByte = 2-bit length codes packed 4 per control byte, followed by the
+// 1-4 data bytes of each value. Decoding 4 values is a single SSSE3 shuffle.
+
+const uint32_t BARREL_MAGIC = 0x4C425252; // "RRBL"
+const uint32_t BARREL_VERSION = 3;     // Written by create_barrels
+const uint32_t BARREL_MIN_VERSION = 2; // Oldest block format still read
+const uint32_t POSTING_BLOCK_SIZE = 128;
+const uint32_t LIST_PADDING = 16; // Lets the SIMD decoder over-read safely
+
+// Header flags
+const uint32_t BARREL_FLAG_BLOCK_MAX = 1; // Lists carry per-block score upper bounds
+
+struct BarrelHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t wordsPerBarrel;
+    uint32_t blockSize;
+    uint32_t flags;
+    // BM25 parameters the block bounds were computed with (0 if no bounds)
+    float avgDL;
+    float k1;
+    float b;
+    // v3: the static scores the bounds' maxPageRank came from
+    // (StaticScores::size() / fingerprint()); bounds only hold for those
+    uint32_t staticDocs;
+    uint32_t reserved;
+    uint64_t staticFingerprint;
+};
+
+// The offset table starts right after the header, whose size depends on the version
+inline size_t barrelHeaderSize(uint32_t version) {
+    return version >= 3 ? sizeof(BarrelHeader) : offsetof(BarrelHeader, staticDocs);
+}
+
+// Header of a block barrel; fields a v2 file doesn't have read as 0
+inline BarrelHeader readBarrelHeader(const uint8_t* base, size_t size) {
+    BarrelHeader header = {};
+    memcpy(&header, base, min(size, barrelHeaderSize(BARREL_MIN_VERSION)));
+    if (header.version >= 3 && size >= sizeof(BarrelHeader)) memcpy(&header, base, sizeof(header));
+    return header;
+}
+
+struct ListHeader {
+    uint32_t count;
+    uint32_t numBlocks;
+};
+
+struct BlockEntry {
+    uint32_t lastDocID;  // Largest docID in the block
+    uint32_t byteOffset; // Relative to the first block of the list
+};
+
+// Per-block upper bounds for dynamic pruning (Block-Max WAND / MaxScore).
+// maxTermScore is the largest BM25 tf-component  tf*(k1+1) / (tf + k1*(1-b+b*dl/avgDL))
+// in the block; the query multiplies it by the term's IDF. maxPageRank is the
+// largest raw PageRank of any doc in the block.
+struct BlockBound {
+    float maxTermScore;
+    float maxPageRank;
+};
+
+// Bounds are stored as float, so round up (with a little slack) to stay >= the exact double
+inline float roundUpBound(double v) {
+    float f = (float)(v * (1.0 + 1e-5));
+    return nextafterf(f, 3.0e38f);
+}
+
+// Returns true if the mapped bytes start with a v2 (or later) header
+inline bool isBlockBarrel(const uint8_t* base, size_t size) {
+    if (size < barrelHeaderSize(BARREL_MIN_VERSION)) return false;
+    uint32_t magic;
+    memcpy(&magic, base, sizeof(magic));
+    return magic == BARREL_MAGIC;
+}
+
+// ---------------------------------------------------------
+// STREAMVBYTE CODEC
+// ---------------------------------------------------------
+inline uint32_t svbCode(uint32_t v) {
+    return (v < (1u << 8)) ? 0 : (v < (1u << 16)) ? 1 : (v < (1u << 24)) ? 2 : 3;
+}
+
+// Appends [control bytes][data bytes] for n values
+inline void svbEncode(const uint32_t* in, uint32_t n, vector<uint8_t>& out) {
+    size_t ctrlPos = out.size();
+    out.resize(ctrlPos + (n + 3) / 4, 0);
+    for (uint32_t i = 0; i < n; ++i) {
+        uint32_t code = svbCode(in[i]);
+        out[ctrlPos + i / 4] |= (uint8_t)(code << ((i % 4) * 2));
+        for (uint32_t b = 0; b <= code; ++b) out.push_back((uint8_t)(in[i] >> (8 * b)));
+    }
+}
+
+// Scalar reference decoder. If 'delta', values are gaps added onto 'prev'.
+// Returns a pointer just past the consumed data bytes.
+inline const uint8_t* svbDecodeScalarStreams(const uint8_t* ctrl, const uint8_t* data, uint32_t n,
+                                             uint32_t* out, bool delta, uint32_t prev) {
+    for (uint32_t i = 0; i < n; ++i) {
+        uint32_t code = (ctrl[i / 4] >> ((i % 4) * 2)) & 3;
+        uint32_t v = 0;
+        for (uint32_t b = 0; b <= code; ++b) v |= (uint32_t)data[b] << (8 * b);
+        data += code + 1;
+        if (delta) { prev += v; v = prev; }
+        out[i] = v;
+    }
+    return data;
+}
+
+inline const uint8_t* svbDecodeScalar(const uint8_t* in, uint32_t n, uint32_t* out, bool delta, uint32_t prev) {
+    return svbDecodeScalarStreams(in, in + (n + 3) / 4, n, out, delta, prev);
+}
+
+#ifdef BARREL_HAVE_X86_SIMD
+// Shuffle masks and group lengths for every possible control byte
+struct SvbTables {
+    uint8_t shuffle[256][16];
+    uint8_t length[256];
+
+    SvbTables() {
+        for (int c = 0; c < 256; ++c) {
+            int pos = 0;
+            for (int j = 0; j < 4; ++j) {
+                int len = ((c >> (2 * j)) & 3) + 1;
+                for (int b = 0; b < 4; ++b) {
+                    shuffle[c][j * 4 + b] = (b < len) ? (uint8_t)(pos + b) : 0xFF;
+                }
+                pos += len;
+            }
+            length[c] = (uint8_t)pos;
+        }
+    }
+};
+
+inline const SvbTables& svbTables() {
+    static const SvbTables tables;
+    return tables;
+}
+
+__attribute__((target("ssse3")))
+inline const uint8_t* svbDecodeSSSE3(const uint8_t* in, uint32_t n, uint32_t* out, bool delta, uint32_t prev) {
+    const SvbTables& t = svbTables();
+    const uint8_t* ctrl = in;
+    const uint8_t* data = in + (n + 3) / 4;
+    uint32_t groups = n / 4;
+    __m128i carry = _mm_set1_epi32((int)prev);
+
+    for (uint32_t g = 0; g < groups; ++g) {
+        uint8_t c = ctrl[g];
+        __m128i raw = _mm_loadu_si128((const __m128i*)data);
+        __m128i v = _mm_shuffle_epi8(raw, _mm_loadu_si128((const __m128i*)t.shuffle[c]));
+        if (delta) {
+            // In-register prefix sum of the 4 gaps, then add the running docID
+            v = _mm_add_epi32(v, _mm_slli_si128(v, 4));
+            v = _mm_add_epi32(v, _mm_slli_si128(v, 8));
+            v = _mm_add_epi32(v, carry);
+            carry = _mm_shuffle_epi32(v, 0xFF);
+        }
+        _mm_storeu_si128((__m128i*)(out + g * 4), v);
+        data += t.length[c];
+    }
+
+    uint32_t done = groups * 4;
+    if (done < n) {
+        // Tail (< 4 values)
+        uint32_t last = (uint32_t)_mm_cvtsi128_si32(carry);
+        data = svbDecodeScalarStreams(ctrl + groups, data, n - done, out + done, delta, last);
+    }
+    return data;
+}
+
+inline bool cpuHasSSSE3() {
+    static const bool has = __builtin_cpu_supports("ssse3");
+    return has;
+}
+#endif
+
+// Runtime dispatch: SSSE3 where the CPU has it, scalar otherwise
+inline const uint8_t* svbDecode(const uint8_t* in, uint32_t n, uint32_t* out, bool delta, uint32_t prev) {
+#ifdef BARREL_HAVE_X86_SIMD
+    if (cpuHasSSSE3()) return svbDecodeSSSE3(in, n, out, delta, prev);
+#endif
+    return svbDecodeScalar(in, n, out, delta, prev);
+}
+
+// ---------------------------------------------------------
+// POSTING LIST ENCODE / DECODE
+// ---------------------------------------------------------
+
+// Appends one v2 posting list. 'docIDs' must be sorted ascending.
+// 'bounds' (one per block) must be given iff the barrel has BARREL_FLAG_BLOCK_MAX.
+inline void encodePostingList(const uint32_t* docIDs, const uint32_t* freqs, uint32_t count, vector<uint8_t>& out,
+                              const BlockBound* bounds = nullptr) {
+    uint32_t numBlocks = (count + POSTING_BLOCK_SIZE - 1) / POSTING_BLOCK_SIZE;
+    vector<BlockEntry> dir(numBlocks);
+    vector<uint8_t> blocks;
+    uint32_t gaps[POSTING_BLOCK_SIZE];
+
+    uint32_t prev = 0;
+    for (uint32_t b = 0; b < numBlocks; ++b) {
+        uint32_t start = b * POSTING_BLOCK_SIZE;
+        uint32_t n = min(POSTING_BLOCK_SIZE, count - start);
+        for (uint32_t i = 0; i < n; ++i) {
+            gaps[i] = docIDs[start + i] - prev;
+            prev = docIDs[start + i];
+        }
+        dir[b] = { prev, (uint32_t)blocks.size() };
+        svbEncode(gaps, n, blocks);
+        svbEncode(freqs + start, n, blocks);
+    }
+
+    ListHeader header = { count, numBlocks };
+    const uint8_t* h = (const uint8_t*)&header;
+    out.insert(out.end(), h, h + sizeof(header));
+    const uint8_t* d = (const uint8_t*)dir.data();
+    out.insert(out.end(), d, d + numBlocks * sizeof(BlockEntry));
+    if (bounds) {
+        const uint8_t* m = (const uint8_t*)bounds;
+        out.insert(out.end(), m, m + numBlocks * sizeof(BlockBound));
+    }
+    out.insert(out.end(), blocks.begin(), blocks.end());
+    out.resize(out.size() + LIST_PADDING, 0);
+    while (out.size() % 4 != 0) out.push_back(0); // Keep the next list aligned
+}
+
+// Read-only view of one v2 posting list inside a mapped barrel
+struct BlockListView {
+    uint32_t count = 0;
+    uint32_t numBlocks = 0;
+    const BlockEntry* dir = nullptr;
+    const BlockBound* bounds = nullptr; // nullptr if the barrel has no block-max data
+    const uint8_t* blocks = nullptr;
+
+    bool empty() const { return count == 0; }
+
+    uint32_t blockSize(uint32_t b) const {
+        uint32_t start = b * POSTING_BLOCK_SIZE;
+        return min(POSTING_BLOCK_SIZE, count - start);
+    }
+
+    // Decodes block 'b' into docIDs/freqs (each POSTING_BLOCK_SIZE long)
+    uint32_t decodeBlock(uint32_t b, uint32_t* docIDs, uint32_t* freqs) const {
+        uint32_t n = blockSize(b);
+        uint32_t base = (b == 0) ? 0 : dir[b - 1].lastDocID;
+        const uint8_t* p = blocks + dir[b].byteOffset;
+        p = svbDecode(p, n, docIDs, true, base);
+        svbDecode(p, n, freqs, false, 0);
+        return n;
+    }
+};
+
+// Offset of a list as stored in a v2 barrel's offset table (0 = no postings)
+inline uint64_t blockListOffset(const uint8_t* base, size_t size, uint32_t localID) {
+    BarrelHeader header = readBarrelHeader(base, size);
+    if (localID >= header.wordsPerBarrel) return 0;
+    size_t slot = barrelHeaderSize(header.version) + (size_t)localID * sizeof(uint64_t);
+    if (slot + sizeof(uint64_t) > size) return 0;
+    uint64_t offset;
+    memcpy(&offset, base + slot, sizeof(offset));
+    return offset;
+}
+
+// Opens the list at 'offset' in a mapped v2 barrel. Returns an empty view on
+// any out-of-range offset so a truncated file can never be read past its end.
+inline BlockListView openBlockListAt(const uint8_t* base, size_t size, uint64_t offset) {
+    BlockListView view;
+    BarrelHeader header = readBarrelHeader(base, size);
+    if (offset == 0 || offset + sizeof(ListHeader) > size) return view;
+
+    ListHeader lh;
+    memcpy(&lh, base + offset, sizeof(lh));
+    size_t dirStart = offset + sizeof(ListHeader);
+    size_t boundStart = dirStart + (size_t)lh.numBlocks * sizeof(BlockEntry);
+    bool hasBounds = (header.flags & BARREL_FLAG_BLOCK_MAX) != 0;
+    size_t blockStart = boundStart + (hasBounds ? (size_t)lh.numBlocks * sizeof(BlockBound) : 0);
+    if (lh.numBlocks != (lh.count + POSTING_BLOCK_SIZE - 1) / POSTING_BLOCK_SIZE) return view;
+    if (blockStart + LIST_PADDING > size) return view;
+    if (lh.numBlocks > 0) {
+        BlockEntry last;
+        memcpy(&last, base + boundStart - sizeof(BlockEntry), sizeof(last));
+        if (blockStart + (size_t)last.byteOffset + LIST_PADDING > size) return view;
+    }
+
+    view.count = lh.count;
+    view.numBlocks = lh.numBlocks;
+    view.dir = (const BlockEntry*)(base + dirStart);
+    view.bounds = hasBounds ? (const BlockBound*)(base + boundStart) : nullptr;
+    view.blocks = base + blockStart;
+    return view;
+}
+
+// Locates a list through the barrel's offset table
+inline BlockListView openBlockList(const uint8_t* base, size_t size, uint32_t localID) {
+    return openBlockListAt(base, size, blockListOffset(base, size, localID));
+}
+
+#endif
+
+/*
+    ========================================================================================
+    EDUCATIONAL SUMMARY: POSTING LIST COMPRESSION
+    ========================================================================================
+
+    1. WHY DELTAS?
+       - Posting lists are sorted by docID: 12, 15, 19, 300 ...
+       - Storing the gaps (12, 3, 4, 281) gives mostly small numbers.
+       - Small numbers need fewer bytes.
+
+    2. STREAMVBYTE
+       - Classic VByte interleaves "continue" bits with data, so decoding branches per byte.
+       - StreamVByte moves all length codes into a separate control stream.
+       - One control byte describes 4 integers -> one table lookup + one SSSE3
+         shuffle (pshufb) decodes all 4 at once. No branches per value.
+
+    3. BLOCKS
+       - Lists are cut into blocks of 128 postings.
+       - The block directory stores each block's last docID, so a reader can skip
+         a whole block without decoding it (used later for intersection & pruning).
+
+    4. BLOCK-MAX BOUNDS
+       - For every block we also store the best BM25 tf-component and the best PageRank.
+       - At query time: IDF * maxTermScore + PAGERANK_WEIGHT * maxPageRank is an upper
+         bound on the score of ANY doc in that block.
+       - If that bound cannot beat the current k-th best score, the block is skipped
+         without being decoded (Block-Max WAND, Ding & Suel 2011).
+       - The bound is only an upper bound for the scores it was computed from. v3
+         headers record which static scores that was (doc count + fingerprint); the
+         engine stops pruning a barrel whose record doesn't match what it loaded.
+*/
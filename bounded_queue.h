@@ -0,0 +1,60 @@
+#ifndef BOUNDED_QUEUE_H
+#define BOUNDED_QUEUE_H
+
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <utility>
+
+using namespace std;
+
+// --- BOUNDED WORK QUEUE ---
+// push() blocks while the queue is full, so a fast producer (the server's
+// accept loop, forward_indexer's reader) waits instead of piling up
+// unbounded work in memory.
+template<typename T>
+class BoundedQueue {
+private:
+    deque<T> items;
+    size_t capacity;
+    bool closed = false;
+    mutex lock;
+    condition_variable notEmpty, notFull;
+
+public:
+    explicit BoundedQueue(size_t cap) : capacity(cap ? cap : 1) {}
+
+    bool push(T item) {
+        unique_lock<mutex> guard(lock);
+        notFull.wait(guard, [&] { return closed || items.size() < capacity; });
+        if (closed) return false;
+        items.push_back(move(item));
+        notEmpty.notify_one();
+        return true;
+    }
+
+    // False once closed and drained
+    bool pop(T& item) {
+        unique_lock<mutex> guard(lock);
+        notEmpty.wait(guard, [&] { return closed || !items.empty(); });
+        if (items.empty()) return false;
+        item = move(items.front());
+        items.pop_front();
+        notFull.notify_one();
+        return true;
+    }
+
+    void close() {
+        lock_guard<mutex> guard(lock);
+        closed = true;
+        notEmpty.notify_all();
+        notFull.notify_all();
+    }
+
+    size_t size() {
+        lock_guard<mutex> guard(lock);
+        return items.size();
+    }
+};
+
+#endif
@@ -3,82 +3,193 @@
 #include <string>
 #include <vector>
 #include <unordered_map>
+#include <algorithm>
+#include <functional>
+#include <chrono>
+#include <thread>
 #include <cstdint>
+#include <cstring>
+#include <cstdlib>
 #include "common.h" // <--- INCLUDES STOPWORDS & TOKENIZER
+#include "lexicon_format.h"
+#include "chunk_reader.h"
 
 using namespace std;
 
-class LexiconBuilder {
+// --- CONFIGURATION ---
+const size_t CHUNK_BYTES = 16 << 20; // Input handed to one worker at a time (whole lines)
+
+// Words of one chunk in the order they first appear there, with their df
+// inside the chunk. A doc is one line, so it never spans two chunks and
+// "once per doc" can be counted locally.
+struct ChunkVocab {
+    vector<string> words;
+    vector<uint32_t> df;
+    vector<vector<uint32_t>> byShard; // Local word indices, grouped by merge shard
+    uint64_t docs = 0;
+};
+
+// Tokenizes every "ID\tcontent" line of 'text' (lines without a tab are
+// skipped, as they always were) into 'out'
+void countChunk(const string& text, size_t numShards, ChunkVocab& out) {
+    unordered_map<string, uint32_t> local;
+    vector<uint32_t> lastDoc; // Last doc of this chunk that counted towards df
+    uint32_t doc = 0;
+    Tokenizer tokenizer;
+    string key; // Reused: a token only becomes a new string when it is a new word
+
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t end = text.find('\n', pos);
+        if (end == string::npos) end = text.size();
+        const char* tab = (const char*)memchr(text.data() + pos, '\t', end - pos);
+        if (tab) {
+            string_view content(tab + 1, (size_t)(text.data() + end - (tab + 1)));
+            for (string_view token : tokenizer.tokenize(content)) {
+                key.assign(token.data(), token.size());
+                auto [it, fresh] = local.try_emplace(key, (uint32_t)out.words.size()); // One lookup
+                if (fresh) {
+                    out.words.push_back(key);
+                    out.df.push_back(0);
+                    lastDoc.push_back(UINT32_MAX);
+                }
+                uint32_t id = it->second;
+                if (lastDoc[id] != doc) {
+                    lastDoc[id] = doc;
+                    out.df[id]++;
+                }
+            }
+            doc++;
+        }
+        pos = end + 1;
+    }
+    out.docs = doc;
+
+    out.byShard.assign(numShards, {});
+    hash<string> hasher;
+    for (uint32_t i = 0; i < out.words.size(); ++i) out.byShard[hasher(out.words[i]) % numShards].push_back(i);
+}
+
+// One slice of the global vocabulary (by hash). A word's 'firstSeen' is
+// (chunk << 32 | index in that chunk): chunks are merged in file order, so
+// the smallest key is where the word first appears in the whole corpus.
+struct ShardEntry {
+    uint64_t firstSeen;
+    uint32_t df;
+};
+
+class LexiconShard {
 private:
-    unordered_map<string, int> wordToID;
-    vector<string> idToWord;
+    unordered_map<string, ShardEntry> entries;
 
 public:
-    int getID(const string& word) {
-        if (wordToID.find(word) != wordToID.end()) {
-            return wordToID[word];
+    void merge(ChunkVocab& chunk, size_t shard, uint64_t chunkNo) {
+        for (uint32_t i : chunk.byShard[shard]) {
+            // try_emplace leaves the string alone if the word is already here
+            auto [it, fresh] = entries.try_emplace(move(chunk.words[i]), ShardEntry{ (chunkNo << 32) | i, 0 });
+            it->second.df += chunk.df[i];
         }
-        int newID = idToWord.size();
-        wordToID[word] = newID;
-        idToWord.push_back(word);
-        return newID;
     }
 
-    void saveBinary(const string& filename) {
-        ofstream outFile(filename, ios::binary);
-        if (!outFile) {
-            cerr << "Error writing " << filename << endl;
-            return;
-        }
-        uint32_t size = (uint32_t)idToWord.size();
-        outFile.write((char*)&size, sizeof(size));
+    size_t size() const { return entries.size(); }
 
-        for (const string& word : idToWord) {
-            uint32_t len = (uint32_t)word.size();
-            outFile.write((char*)&len, sizeof(len));
-            outFile.write(word.c_str(), len);
-        }
-        outFile.close();
+    void collect(vector<pair<uint64_t, const pair<const string, ShardEntry>*>>& out) const {
+        for (const auto& e : entries) out.push_back({ e.second.firstSeen, &e });
     }
-    
-    // Helper to print debug info
-    int getTotalWords() { return idToWord.size(); }
 };
 
-int main() {
-    LexiconBuilder lexicon;
-    ifstream file("C:\\Users\\Hank47\\Sem3\\Rummager\\clean_dataset.txt");
-    
+double secondsSince(chrono::steady_clock::time_point& mark) {
+    auto now = chrono::steady_clock::now();
+    double s = chrono::duration<double>(now - mark).count();
+    mark = now;
+    return s;
+}
+
+int main(int argc, char* argv[]) {
+    size_t threads = max(thread::hardware_concurrency(), 1u);
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--threads" && i + 1 < argc) threads = max(atoi(argv[++i]), 1);
+    }
+
+    ifstream file("C:\\Users\\Hank47\\Sem3\\Rummager\\clean_dataset.txt", ios::binary);
     if (!file.is_open()) {
         cerr << "Error: Run preprocess.py first!" << endl;
         return 1;
     }
 
-    string line;
-    int count = 0;
-    cout << "Building Lexicon..." << endl;
+    cout << "Building Lexicon (" << threads << " threads)..." << endl;
 
-    while (getline(file, line)) {
-        size_t tabPos = line.find('\t');
-        if (tabPos == string::npos) continue;
+    // --- PHASE 1+2: COUNT (chunks in parallel) AND MERGE (shards in parallel) ---
+    // One round = one chunk per thread. The next round is read while this one
+    // is counted and merged.
+    vector<LexiconShard> shards(threads);
+    double readWait = 0, countTime = 0, mergeTime = 0;
+    uint64_t chunkNo = 0, docs = 0;
+    string carry;
+    auto mark = chrono::steady_clock::now();
 
-        string content = line.substr(tabPos + 1);
-        
-        // USES SHARED TOKENIZER
-        vector<string> tokens = Tokenize::tokenize(content);
+    vector<string> round = readChunks(file, carry, threads, CHUNK_BYTES);
+    readWait += secondsSince(mark);
+    while (!round.empty()) {
+        vector<string> nextRound;
+        thread reader([&] { nextRound = readChunks(file, carry, threads, CHUNK_BYTES); });
+
+        vector<ChunkVocab> vocab(round.size());
+        vector<thread> workers;
+        for (size_t c = 0; c < round.size(); ++c) {
+            workers.emplace_back([&, c] { countChunk(round[c], threads, vocab[c]); });
+        }
+        for (thread& t : workers) t.join();
+        countTime += secondsSince(mark);
 
-        for (const string& token : tokens) {
-            lexicon.getID(token);
+        workers.clear();
+        for (size_t s = 0; s < threads; ++s) {
+            workers.emplace_back([&, s] {
+                for (size_t c = 0; c < vocab.size(); ++c) shards[s].merge(vocab[c], s, chunkNo + c);
+            });
         }
+        for (thread& t : workers) t.join();
+        mergeTime += secondsSince(mark);
+
+        for (const ChunkVocab& v : vocab) docs += v.docs;
+        chunkNo += round.size();
+        cout << "Processed " << docs << " lines...\r" << flush;
+
+        reader.join();
+        readWait += secondsSince(mark);
+        round.swap(nextRound);
+    }
 
-        count++;
-        if (count % 10000 == 0) cout << "Processed " << count << " lines...\r" << flush;
+    // --- PHASE 3: IDS IN ORDER OF FIRST APPEARANCE (same as a serial pass) ---
+    vector<pair<uint64_t, const pair<const string, ShardEntry>*>> order;
+    size_t total = 0;
+    for (const LexiconShard& shard : shards) total += shard.size();
+    order.reserve(total);
+    for (const LexiconShard& shard : shards) shard.collect(order);
+    sort(order.begin(), order.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    vector<string> words;
+    vector<uint32_t> docFreq;
+    words.reserve(order.size());
+    docFreq.reserve(order.size());
+    for (const auto& o : order) {
+        words.push_back(o.second->first);
+        docFreq.push_back(o.second->second.df);
     }
+    double assignTime = secondsSince(mark);
 
+    // --- PHASE 4: SAVE (lexicon v2; list offsets are filled in by create_barrels) ---
     cout << "\nSaving lexicon.bin..." << endl;
-    lexicon.saveBinary("C:\\Users\\Hank47\\Sem3\\Rummager\\lexicon.bin");
-    cout << "Done. Total words: " << lexicon.getTotalWords() << endl;
+    if (!writeLexicon("C:\\Users\\Hank47\\Sem3\\Rummager\\lexicon.bin", words, docFreq)) {
+        cerr << "Error writing lexicon.bin" << endl;
+        return 1;
+    }
+    double writeTime = secondsSince(mark);
 
+    cout << "Done. Total words: " << words.size() << endl;
+    cout << "Phase timings (s): read wait " << readWait << " | count " << countTime << " | merge " << mergeTime
+         << " | assign " << assignTime << " | write " << writeTime << endl;
     return 0;
 }
 
@@ -86,20 +197,31 @@ int main() {
     ========================================================================================
     EDUCATIONAL SUMMARY: LEXICON CONSTRUCTION
     ========================================================================================
-    
+
     1. THE PROBLEM
        - We need to map string words ("algorithm") to integer IDs (42).
        - Integers are faster to process, smaller to store, and easier to array-index.
-    
+
     2. DATA STRUCTURE: HASH MAP (unordered_map)
        - We use `std::unordered_map<string, int>` for O(1) average lookup/insertion.
        - Logic:
          - Read word.
          - If in map, return ID.
          - If not, assign new ID = current_size, insert into map.
-    
+
     3. PERSISTENCE
        - The map is in RAM. We must save it to disk (`lexicon.bin`) so other programs
          (indexer, search engine) can understand the IDs.
-       - Format: [TotalWords] [Len1][Word1] [Len2][Word2] ...
-*/
\ No newline at end of file
+       - Format: lexicon v2 (see lexicon_format.h). Words, their df and a perfect
+         hash, so readers map the file instead of rebuilding this map.
+
+    4. PARALLEL BUILD ("--threads N", default = all cores)
+       - The input is cut into 16 MB chunks of whole lines; each worker counts one
+         chunk into its own map (words in first-seen order + df).
+       - The chunk vocabularies are merged into N shards (word hash % N), each
+         shard by its own thread, visiting chunks in file order.
+       - IDs are then handed out by (chunk, position in chunk) of each word's
+         first appearance: exactly the order a single thread would have seen, so
+         lexicon.bin is identical whatever the thread count.
+       - Reading the next round of chunks overlaps the counting of this one.
+*/
@@ -0,0 +1,179 @@
+#ifndef CATEGORY_FORMAT_H
+#define CATEGORY_FORMAT_H
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <map>
+
+using namespace std;
+
+// ---------------------------------------------------------
+// CATEGORY POSTINGS (categories.bin, next to the barrels)
+// ---------------------------------------------------------
+// One docID set per arXiv category, built from the Category column of
+// doc_metadata.txt ("cs.AI cs.LG" = member of both).
+//
+//   [CategoryHeader]
+//   [CategoryEntry x numCategories]      <- sorted by name
+//   [Names: raw chars, back to back]
+//   per category (8-byte aligned):
+//     CATEGORY_LIST   : uint32 docID x count (ascending)
+//     CATEGORY_BITMAP : uint64 x ceil(numDocs / 64), bit d = doc d
+//
+// Like a roaring container, each set picks the smaller encoding: a sorted
+// list while it holds under 1/32 of the collection, a bitmap beyond that.
+
+const uint32_t CATEGORY_MAGIC = 0x54414352; // "RCAT"
+const uint32_t CATEGORY_VERSION = 1;
+
+const uint32_t CATEGORY_LIST = 0;
+const uint32_t CATEGORY_BITMAP = 1;
+
+struct CategoryHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t numDocs;
+    uint32_t numCategories;
+};
+
+struct CategoryEntry {
+    uint32_t nameOffset; // Into the names area
+    uint32_t nameLength;
+    uint32_t count;      // Docs in the category
+    uint32_t kind;       // CATEGORY_LIST or CATEGORY_BITMAP
+    uint64_t dataOffset; // From the start of the file
+};
+
+inline size_t bitmapWords(uint32_t numDocs) { return ((size_t)numDocs + 63) / 64; }
+
+// A list costs 32 bits per doc, a bitmap 1 bit per doc of the collection
+inline uint32_t chooseCategoryKind(uint32_t count, uint32_t numDocs) {
+    return ((uint64_t)count * 32 < numDocs) ? CATEGORY_LIST : CATEGORY_BITMAP;
+}
+
+// "cs.AI cs.LG" -> {"cs.AI", "cs.LG"}
+inline vector<string> splitCategories(const string& field) {
+    vector<string> names;
+    size_t i = 0;
+    while (i < field.size()) {
+        while (i < field.size() && isspace((unsigned char)field[i])) i++;
+        size_t start = i;
+        while (i < field.size() && !isspace((unsigned char)field[i])) i++;
+        if (i > start) names.push_back(field.substr(start, i - start));
+    }
+    return names;
+}
+
+// --- BUILDING (create_barrels, or the engine if categories.bin is missing) ---
+
+// 'fields[d]' = Category column of doc d. Returns the whole file image.
+inline vector<uint8_t> buildCategoryIndex(const vector<string>& fields) {
+    map<string, vector<uint32_t>> sets; // Sorted by name; docs ascending since d only grows
+    for (uint32_t d = 0; d < fields.size(); ++d) {
+        for (const string& name : splitCategories(fields[d])) {
+            vector<uint32_t>& docs = sets[name];
+            if (docs.empty() || docs.back() != d) docs.push_back(d); // Listed twice = once
+        }
+    }
+
+    uint32_t numDocs = (uint32_t)fields.size();
+    CategoryHeader header = { CATEGORY_MAGIC, CATEGORY_VERSION, numDocs, (uint32_t)sets.size() };
+    vector<CategoryEntry> entries;
+    string names;
+    for (const auto& s : sets) {
+        uint32_t count = (uint32_t)s.second.size();
+        entries.push_back({ (uint32_t)names.size(), (uint32_t)s.first.size(), count,
+                            chooseCategoryKind(count, numDocs), 0 });
+        names += s.first;
+    }
+
+    vector<uint8_t> out(sizeof(header) + entries.size() * sizeof(CategoryEntry));
+    out.insert(out.end(), names.begin(), names.end());
+
+    size_t i = 0;
+    for (const auto& s : sets) {
+        CategoryEntry& e = entries[i++];
+        while (out.size() % 8 != 0) out.push_back(0);
+        e.dataOffset = out.size();
+        if (e.kind == CATEGORY_LIST) {
+            const uint8_t* p = (const uint8_t*)s.second.data();
+            out.insert(out.end(), p, p + s.second.size() * sizeof(uint32_t));
+        } else {
+            vector<uint64_t> bits(bitmapWords(numDocs), 0);
+            for (uint32_t d : s.second) bits[d / 64] |= 1ULL << (d % 64);
+            const uint8_t* p = (const uint8_t*)bits.data();
+            out.insert(out.end(), p, p + bits.size() * sizeof(uint64_t));
+        }
+    }
+
+    memcpy(out.data(), &header, sizeof(header));
+    if (!entries.empty()) memcpy(out.data() + sizeof(header), entries.data(), entries.size() * sizeof(CategoryEntry));
+    return out;
+}
+
+// --- READING (searchengine) ---
+
+// Read-only view of one category inside a categories.bin image
+struct CategoryView {
+    string name;
+    uint32_t count = 0;
+    uint32_t kind = CATEGORY_LIST;
+    const uint32_t* docs = nullptr; // CATEGORY_LIST
+    const uint64_t* bits = nullptr; // CATEGORY_BITMAP
+};
+
+// Parses an image (mapped file or built in memory). False on any
+// inconsistency; 'views' point into 'base', which must outlive them.
+inline bool readCategoryIndex(const uint8_t* base, size_t size, uint32_t& numDocs, vector<CategoryView>& views) {
+    views.clear();
+    if (size < sizeof(CategoryHeader)) return false;
+    CategoryHeader header;
+    memcpy(&header, base, sizeof(header));
+    if (header.magic != CATEGORY_MAGIC || header.version != CATEGORY_VERSION) return false;
+
+    size_t namesStart = sizeof(header) + (size_t)header.numCategories * sizeof(CategoryEntry);
+    if (namesStart > size) return false;
+
+    for (uint32_t c = 0; c < header.numCategories; ++c) {
+        CategoryEntry e;
+        memcpy(&e, base + sizeof(header) + (size_t)c * sizeof(CategoryEntry), sizeof(e));
+        size_t bytes = (e.kind == CATEGORY_LIST) ? (size_t)e.count * sizeof(uint32_t)
+                                                 : bitmapWords(header.numDocs) * sizeof(uint64_t);
+        if (namesStart + e.nameOffset + e.nameLength > size || e.dataOffset % 8 != 0 ||
+            e.dataOffset + bytes > size || e.kind > CATEGORY_BITMAP) {
+            views.clear();
+            return false;
+        }
+
+        CategoryView v;
+        v.name.assign((const char*)base + namesStart + e.nameOffset, e.nameLength);
+        v.count = e.count;
+        v.kind = e.kind;
+        if (e.kind == CATEGORY_LIST) v.docs = (const uint32_t*)(base + e.dataOffset);
+        else v.bits = (const uint64_t*)(base + e.dataOffset);
+        views.push_back(v);
+    }
+    numDocs = header.numDocs;
+    return true;
+}
+
+#endif
+
+/*
+    ========================================================================================
+    EDUCATIONAL SUMMARY: CATEGORY POSTINGS
+    ========================================================================================
+
+    1. WHY?
+       - "/cat:cs.AI" used to be checked after scoring, with a substring search in
+         every candidate's metadata string.
+       - A category is just another set of docIDs, so it can be built once at index
+         time and intersected with the term lists like any posting list.
+
+    2. TWO CONTAINERS
+       - Rare categories: sorted docID list (small, galloping skips far ahead).
+       - Common categories: bitmap (membership is one bit test, size fixed at N/8).
+*/
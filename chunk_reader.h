@@ -0,0 +1,42 @@
+#ifndef CHUNK_READER_H
+#define CHUNK_READER_H
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// ---------------------------------------------------------
+// WHOLE-LINE CHUNKS (build_lexicon, forward_indexer)
+// ---------------------------------------------------------
+// clean_dataset.txt is one doc per line, so a chunk that ends on a newline
+// can be tokenized by any thread without looking at its neighbours.
+
+// Reads the next 'count' chunks of about 'chunkBytes', each cut after its
+// last newline; the partial line at the end is carried into the following
+// chunk. Open the file with ios::binary.
+inline vector<string> readChunks(ifstream& file, string& carry, size_t count, size_t chunkBytes) {
+    vector<string> chunks;
+    while (chunks.size() < count && (file || !carry.empty())) {
+        string chunk;
+        chunk.swap(carry);
+        while (file) { // Until the chunk ends on a newline (a line longer than a chunk grows it)
+            size_t have = chunk.size();
+            chunk.resize(have + chunkBytes);
+            file.read(&chunk[have], chunkBytes);
+            chunk.resize(have + (size_t)file.gcount());
+            if (!file) break; // End of input: the rest is the last line
+            size_t lastNewline = chunk.rfind('\n');
+            if (lastNewline != string::npos && lastNewline >= have) {
+                carry.assign(chunk, lastNewline + 1, string::npos);
+                chunk.resize(lastNewline + 1);
+                break;
+            }
+        }
+        if (!chunk.empty()) chunks.push_back(move(chunk));
+    }
+    return chunks;
+}
+
+#endif
@@ -4,15 +4,17 @@
 #include <iostream>
 #include <string>
 #include <vector>
-#include <unordered_set>
+#include <string_view>
+#include <array>
 #include <algorithm>
+#include <cstdint>
 
 using namespace std;
 
 // ---------------------------------------------------------
 // SHARED CONSTANTS
 // ---------------------------------------------------------
-const unordered_set<string> STOPWORDS = {
+constexpr string_view STOPWORD_LIST[] = {
     "a", "about", "above", "after", "again", "against", "all", "am", "an", "and",
     "any", "are", "aren't", "as", "at", "be", "because", "been", "before", "being",
     "below", "between", "both", "but", "by", "can't", "cannot", "could", "couldn't",
@@ -34,39 +36,112 @@ const unordered_set<string> STOPWORDS = {
     "wouldn't", "you", "you'd", "you'll", "you're", "you've", "your", "yours",
     "yourself", "yourselves"
 };
+constexpr size_t NUM_STOPWORDS = sizeof(STOPWORD_LIST) / sizeof(STOPWORD_LIST[0]);
+
+// --- STOPWORD PERFECT HASH (built by the compiler) ---
+// Every stopword lands in its own slot of a 1 KB table for this seed, so a
+// lookup is one hash, one byte and at most one compare. Changed the list? If
+// the static_assert fires, try seeds until it doesn't.
+const size_t STOPWORD_SLOTS = 1024;
+const uint64_t STOPWORD_SEED = 1318352;
+const size_t MAX_STOPWORD_LENGTH = 10;
+const uint8_t NO_STOPWORD = 0xFF;
+
+constexpr uint64_t stopwordHash(string_view s) {
+    uint64_t h = STOPWORD_SEED;
+    for (char c : s) {
+        h ^= (unsigned char)c;
+        h *= 0x100000001b3ULL;
+    }
+    return h ^ (h >> 29);
+}
+
+struct StopwordTable {
+    uint8_t slot[STOPWORD_SLOTS];
+    bool perfect;
+};
+
+constexpr StopwordTable buildStopwordTable() {
+    StopwordTable table{};
+    for (size_t i = 0; i < STOPWORD_SLOTS; ++i) table.slot[i] = NO_STOPWORD;
+    table.perfect = true;
+    for (size_t i = 0; i < NUM_STOPWORDS; ++i) {
+        size_t k = stopwordHash(STOPWORD_LIST[i]) & (STOPWORD_SLOTS - 1);
+        if (table.slot[k] != NO_STOPWORD || STOPWORD_LIST[i].size() > MAX_STOPWORD_LENGTH) table.perfect = false;
+        table.slot[k] = (uint8_t)i;
+    }
+    return table;
+}
+
+constexpr StopwordTable STOPWORD_TABLE = buildStopwordTable();
+static_assert(NUM_STOPWORDS < NO_STOPWORD, "stopword slots hold 8-bit indices");
+static_assert(STOPWORD_TABLE.perfect, "stopwords collide for STOPWORD_SEED: pick another seed");
+
+inline bool isStopword(string_view token) {
+    if (token.size() > MAX_STOPWORD_LENGTH) return false;
+    uint8_t i = STOPWORD_TABLE.slot[stopwordHash(token) & (STOPWORD_SLOTS - 1)];
+    return i != NO_STOPWORD && STOPWORD_LIST[i] == token;
+}
 
 // ---------------------------------------------------------
 // SHARED TOKENIZER
 // ---------------------------------------------------------
-class Tokenize {
+// A token is a run of ASCII letters and digits, lowercased; every other byte
+// (including UTF-8) separates tokens. One table lookup per byte: 0 = separator,
+// else the byte to emit.
+constexpr array<char, 256> buildTokenChars() {
+    array<char, 256> table{};
+    for (int c = '0'; c <= '9'; ++c) table[c] = (char)c;
+    for (int c = 'a'; c <= 'z'; ++c) table[c] = (char)c;
+    for (int c = 'A'; c <= 'Z'; ++c) table[c] = (char)(c - 'A' + 'a');
+    return table;
+}
+
+constexpr array<char, 256> TOKEN_CHARS = buildTokenChars();
+
+// Reusable tokenizer: the tokens are views into its own buffer, valid until
+// the next tokenize() call. Keep one per thread (or per loop); once the buffer
+// has grown to the longest text, tokenizing allocates nothing.
+class Tokenizer {
+private:
+    string buffer; // Lowercased tokens, back to back
+    vector<string_view> tokens;
+
 public:
-    static vector<string> tokenize(const string& text) {
-        vector<string> tokens;
-        string currentToken;
-        tokens.reserve(text.length() / 6); 
-
-        for (char c : text) {
-            if (isalnum(c)) {
-                currentToken += tolower(c);
-            } else {
-                if (!currentToken.empty()) {
-                    if (STOPWORDS.find(currentToken) == STOPWORDS.end()) {
-                        tokens.push_back(currentToken);
-                    }
-                    currentToken = "";
-                }
-            }
-        }
+    const vector<string_view>& tokenize(string_view text) {
+        tokens.clear();
+        if (buffer.size() < text.size()) buffer.resize(text.size()); // Tokens never outgrow the text
+        char* out = buffer.data();
+        const unsigned char* p = (const unsigned char*)text.data();
+        const unsigned char* end = p + text.size();
 
-        if (!currentToken.empty()) {
-            if (STOPWORDS.find(currentToken) == STOPWORDS.end()) {
-                tokens.push_back(currentToken);
+        while (p < end) {
+            while (p < end && TOKEN_CHARS[*p] == 0) ++p;
+            char* start = out;
+            char c;
+            while (p < end && (c = TOKEN_CHARS[*p]) != 0) {
+                *out++ = c;
+                ++p;
             }
+            if (out == start) break;
+            string_view token(start, (size_t)(out - start));
+            if (isStopword(token)) out = start; // Its bytes are reused by the next token
+            else tokens.push_back(token);
         }
         return tokens;
     }
 };
 
+class Tokenize {
+public:
+    // Owning copies, for callers that keep the tokens (queries, phrases)
+    static vector<string> tokenize(const string& text) {
+        thread_local Tokenizer tokenizer;
+        const vector<string_view>& views = tokenizer.tokenize(text);
+        return vector<string>(views.begin(), views.end());
+    }
+};
+
 #endif
 
 /*
@@ -82,4 +157,12 @@ public:
        - Words like "the", "is", "at" appear in almost every document.
        - They confuse the ranking algorithm (low IDF) and waste space.
        - Removing them improves "Precision" (Relevance) and reduces Index size.
+
+    3. SPEED
+       - Every stage tokenizes the whole corpus (build_lexicon, forward_indexer) or
+         every request (searchengine), so the tokenizer is table-driven: one lookup
+         per byte classifies and lowercases, tokens are views into a reused buffer,
+         and the stopword check is a perfect hash the compiler builds.
+       - tokenizer_bench checks it against the original implementation on the
+         corpus and reports MB/s per core.
 */
\ No newline at end of file
@@ -3,7 +3,17 @@
 #include <vector>
 #include <string>
 #include <cstdint>
+#include <algorithm>
+#include <cstdio>
+#include <numeric>
 #include <sys/stat.h>
+#include "barrel_format.h"
+#include "position_format.h"
+#include "category_format.h"
+#include "date_format.h"
+#include "lexicon_format.h"
+#include "metadata_format.h"
+#include "static_score_format.h"
 
 using namespace std;
 
@@ -11,15 +21,85 @@ using namespace std;
 const string INVERTED_INDEX_FILE = "C:\\Users\\Hank47\\Sem3\\Rummager\\inverted_index.bin";
 string BARREL_DIR = "C:\\Users\\Hank47\\Sem3\\Rummager\\barrels\\"; // Not const anymore
 const string LEXICON_FILE = "C:\\Users\\Hank47\\Sem3\\Rummager\\lexicon.bin";
+const string LENGTHS_FILE = "C:\\Users\\Hank47\\Sem3\\Rummager\\doc_lengths.bin";
+const string PAGERANK_FILE = "C:\\Users\\Hank47\\Sem3\\Rummager\\pagerank_scores.txt";
+const string STATIC_SCORES_FILE = "C:\\Users\\Hank47\\Sem3\\Rummager\\static_scores.bin";
+const string INVERTED_POS_FILE = "C:\\Users\\Hank47\\Sem3\\Rummager\\inverted_positions.bin"; // Optional
+const string META_FILE = "C:\\Users\\Hank47\\Sem3\\Rummager\\doc_metadata.txt";
+const string DATES_FILE = "C:\\Users\\Hank47\\Sem3\\Rummager\\doc_dates.bin";
+const string META_STORE_FILE = "C:\\Users\\Hank47\\Sem3\\Rummager\\doc_metadata.bin";
 
 // MUST match searchengine.cpp
 const uint32_t WORDS_PER_BARREL = 50000; 
 
+// 1 = legacy raw postings, 2 = compressed blocks (see barrel_format.h)
+int BARREL_FORMAT = 2;
+
 struct Posting {
     uint32_t docID;
     uint32_t freq;
 };
 
+static_assert(POSITION_BLOCK_SIZE == POSTING_BLOCK_SIZE, "Position blocks must line up with posting blocks");
+
+// BM25 parameters for the block-max bounds. MUST match searchengine.cpp
+const double K1 = 1.5;
+const double B = 0.75;
+
+// Per word: where its list landed and how many docs it has. Written back
+// into lexicon.bin (v2 keeps both inline) once every barrel is built.
+vector<uint64_t> listOffsets;
+vector<uint32_t> listDF;
+
+void recordOffset(int barrelID, uint32_t local, uint64_t offset) {
+    size_t w = (size_t)barrelID * WORDS_PER_BARREL + local;
+    if (w < listOffsets.size()) listOffsets[w] = offset;
+}
+
+// Doc statistics for block-max bounds (empty = bounds disabled)
+vector<uint32_t> docLengths;
+StaticScores staticScores;
+double avgDL = 0;
+
+// Loads exactly what the engine loads, so the bounds agree with its scores
+bool loadDocStats() {
+    ifstream lenFile(LENGTHS_FILE, ios::binary);
+    if (!lenFile) return false;
+    uint32_t totalDocs = 0;
+    lenFile.read((char*)&totalDocs, sizeof(totalDocs));
+    docLengths.resize(totalDocs);
+    lenFile.read((char*)docLengths.data(), totalDocs * sizeof(uint32_t));
+    lenFile.close();
+
+    long long sum = 0;
+    for (uint32_t l : docLengths) sum += l;
+    avgDL = (totalDocs > 0) ? (double)sum / totalDocs : 0;
+
+    staticScores.load(STATIC_SCORES_FILE, PAGERANK_FILE, totalDocs);
+    return totalDocs > 0 && avgDL > 0;
+}
+
+// Best possible BM25 tf-component and PageRank inside each block of a list
+vector<BlockBound> computeBlockBounds(const vector<Posting>& list) {
+    vector<BlockBound> bounds;
+    for (size_t start = 0; start < list.size(); start += POSTING_BLOCK_SIZE) {
+        size_t end = min(list.size(), start + POSTING_BLOCK_SIZE);
+        double maxTerm = 0, maxValue = 0;
+        for (size_t k = start; k < end; ++k) {
+            uint32_t doc = list[k].docID;
+            // Unknown length -> 0, which maximises the tf-component (safe)
+            double dl = (doc < docLengths.size()) ? (double)docLengths[doc] : 0.0;
+            double tf = (double)list[k].freq;
+            double term = (tf * (K1 + 1)) / (tf + K1 * (1 - B + B * (dl / avgDL)));
+            maxTerm = max(maxTerm, term);
+            maxValue = max(maxValue, staticScores.value(doc));
+        }
+        // Bounds hold plain PageRank: a folded file is divided back by its weight
+        bounds.push_back({ roundUpBound(maxTerm), roundUpBound(maxValue / staticScores.weight()) });
+    }
+    return bounds;
+}
+
 // Helper: Ensure directory exists
 void createDir(const string& path) {
     #ifdef _WIN32
@@ -30,7 +110,7 @@ void createDir(const string& path) {
     #endif
 }
 
-void writeBarrel(int barrelID, const vector<vector<Posting>>& barrelData) {
+void writeBarrelV1(int barrelID, const vector<vector<Posting>>& barrelData) {
     string filename = BARREL_DIR + "barrel_" + to_string(barrelID) + ".bin";
     ofstream outFile(filename, ios::binary);
     
@@ -52,6 +132,7 @@ void writeBarrel(int barrelID, const vector<vector<Posting>>& barrelData) {
     for (uint32_t i = 0; i < WORDS_PER_BARREL; ++i) {
         if (i < barrelData.size() && !barrelData[i].empty()) {
             offsets[i] = currentFileOffset;
+            recordOffset(barrelID, i, (uint64_t)currentFileOffset);
             
             // Size of this posting list on disk:
             // [ListSize (4 bytes)] + [Posting1] + [Posting2] ...
@@ -78,26 +159,335 @@ void writeBarrel(int barrelID, const vector<vector<Posting>>& barrelData) {
     outFile.close();
 }
 
+// Deltas need ascending docIDs. Positions (if any) are moved along with their postings.
+void sortPostings(vector<Posting>& list, vector<uint32_t>* positions) {
+    auto byDoc = [](const Posting& a, const Posting& b) { return a.docID < b.docID; };
+    if (is_sorted(list.begin(), list.end(), byDoc)) return;
+    if (positions == nullptr || positions->empty()) {
+        stable_sort(list.begin(), list.end(), byDoc);
+        return;
+    }
+
+    vector<size_t> start(list.size()), order(list.size());
+    size_t p = 0;
+    for (size_t k = 0; k < list.size(); ++k) { start[k] = p; p += list[k].freq; }
+    iota(order.begin(), order.end(), 0);
+    stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return list[a].docID < list[b].docID; });
+
+    vector<Posting> sortedList;
+    vector<uint32_t> sortedPositions;
+    sortedList.reserve(list.size());
+    sortedPositions.reserve(positions->size());
+    for (size_t k : order) {
+        sortedList.push_back(list[k]);
+        sortedPositions.insert(sortedPositions.end(), positions->begin() + start[k],
+                               positions->begin() + start[k] + list[k].freq);
+    }
+    list.swap(sortedList);
+    positions->swap(sortedPositions);
+}
+
+void writeBarrelV2(int barrelID, vector<vector<Posting>>& barrelData, vector<vector<uint32_t>>* positions = nullptr) {
+    string filename = BARREL_DIR + "barrel_" + to_string(barrelID) + ".bin";
+    ofstream outFile(filename, ios::binary);
+
+    if (!outFile) {
+        cerr << "Error: Could not create " << filename << endl;
+        return;
+    }
+
+    BarrelHeader header = {};
+    header.magic = BARREL_MAGIC;
+    header.version = BARREL_VERSION;
+    header.wordsPerBarrel = WORDS_PER_BARREL;
+    header.blockSize = POSTING_BLOCK_SIZE;
+    bool withBounds = !docLengths.empty();
+    if (withBounds) {
+        header.flags |= BARREL_FLAG_BLOCK_MAX;
+        header.avgDL = (float)avgDL;
+        header.k1 = (float)K1;
+        header.b = (float)B;
+        header.staticDocs = staticScores.size();
+        header.staticFingerprint = staticScores.fingerprint();
+    }
+
+    // 1. Encode every list into one buffer, remembering where each starts
+    vector<uint64_t> offsets(WORDS_PER_BARREL, 0);
+    uint64_t dataStart = sizeof(BarrelHeader) + WORDS_PER_BARREL * sizeof(uint64_t);
+    vector<uint8_t> data;
+    vector<uint32_t> docIDs, freqs;
+    size_t rawBytes = 0;
+
+    cout << "  Encoding Barrel " << barrelID << " (v2)..." << endl;
+    for (uint32_t i = 0; i < WORDS_PER_BARREL; ++i) {
+        if (i >= barrelData.size() || barrelData[i].empty()) continue;
+        vector<Posting>& list = barrelData[i];
+
+        sortPostings(list, positions ? &(*positions)[i] : nullptr);
+
+        docIDs.resize(list.size());
+        freqs.resize(list.size());
+        for (size_t k = 0; k < list.size(); ++k) {
+            docIDs[k] = list[k].docID;
+            freqs[k] = list[k].freq;
+        }
+
+        offsets[i] = dataStart + data.size();
+        recordOffset(barrelID, i, offsets[i]);
+        if (withBounds) {
+            vector<BlockBound> bounds = computeBlockBounds(list);
+            encodePostingList(docIDs.data(), freqs.data(), (uint32_t)list.size(), data, bounds.data());
+        } else {
+            encodePostingList(docIDs.data(), freqs.data(), (uint32_t)list.size(), data);
+        }
+        rawBytes += sizeof(uint32_t) + list.size() * sizeof(Posting);
+    }
+
+    // 2. Header, Offset Table, Lists
+    outFile.write((char*)&header, sizeof(header));
+    outFile.write((char*)offsets.data(), offsets.size() * sizeof(uint64_t));
+    outFile.write((char*)data.data(), data.size());
+    outFile.close();
+
+    if (rawBytes > 0) {
+        cout << "  Postings: " << rawBytes / 1024 << " KB raw -> " << data.size() / 1024 << " KB encoded" << endl;
+    }
+}
+
+// barrel_N.pos: positions of every posting, in the barrel's posting order
+void writePositions(int barrelID, const vector<vector<Posting>>& barrelData, const vector<vector<uint32_t>>& positions) {
+    string filename = BARREL_DIR + "barrel_" + to_string(barrelID) + ".pos";
+    ofstream outFile(filename, ios::binary);
+    if (!outFile) {
+        cerr << "Error: Could not create " << filename << endl;
+        return;
+    }
+
+    PositionHeader header = { POSITION_MAGIC, POSITION_VERSION, WORDS_PER_BARREL, POSITION_BLOCK_SIZE };
+    vector<uint64_t> offsets(WORDS_PER_BARREL, 0);
+    uint64_t dataStart = sizeof(PositionHeader) + WORDS_PER_BARREL * sizeof(uint64_t);
+    vector<uint8_t> data;
+    vector<uint32_t> freqs;
+    size_t rawBytes = 0;
+
+    for (uint32_t i = 0; i < WORDS_PER_BARREL; ++i) {
+        if (i >= barrelData.size() || barrelData[i].empty() || positions[i].empty()) continue;
+        const vector<Posting>& list = barrelData[i];
+        freqs.resize(list.size());
+        for (size_t k = 0; k < list.size(); ++k) freqs[k] = list[k].freq;
+
+        offsets[i] = dataStart + data.size();
+        encodePositionList(freqs.data(), positions[i].data(), (uint32_t)list.size(), data);
+        rawBytes += positions[i].size() * sizeof(uint32_t);
+    }
+
+    outFile.write((char*)&header, sizeof(header));
+    outFile.write((char*)offsets.data(), offsets.size() * sizeof(uint64_t));
+    outFile.write((char*)data.data(), data.size());
+    outFile.close();
+
+    if (rawBytes > 0) {
+        cout << "  Positions: " << rawBytes / 1024 << " KB raw -> " << data.size() / 1024 << " KB encoded" << endl;
+    }
+}
+
+// 'positions' = nullptr when the index has no positional data
+void writeBarrel(int barrelID, vector<vector<Posting>>& barrelData, vector<vector<uint32_t>>* positions = nullptr) {
+    if (BARREL_FORMAT == 1) writeBarrelV1(barrelID, barrelData);
+    else writeBarrelV2(barrelID, barrelData, positions);
+
+    if (positions) {
+        writePositions(barrelID, barrelData, *positions);
+    } else {
+        // A stale .pos from an older build would no longer match this barrel
+        remove((BARREL_DIR + "barrel_" + to_string(barrelID) + ".pos").c_str());
+    }
+}
+
+// Columns derived from doc_metadata.txt:
+//   categories.bin (in the barrel dir): one docID set per arXiv category (see category_format.h)
+//   doc_dates.bin  (next to doc_lengths.bin): day number per doc (see date_format.h)
+//   doc_metadata.bin (next to doc_metadata.txt): every field, column by column (see metadata_format.h)
+bool writeMetadataColumns() {
+    ifstream mFile(META_FILE);
+    if (!mFile) return false;
+
+    // Line d = doc d. Split "ID|Title|Authors|Category|Date" like the engine does
+    vector<string> fields;
+    vector<uint32_t> days;
+    MetadataStoreBuilder store;
+    const char* parts[META_FIELDS];
+    size_t lengths[META_FIELDS];
+    string line;
+    while (getline(mFile, line)) {
+        splitMetadataLine(line, parts, lengths);
+        fields.emplace_back(parts[META_CATEGORY], lengths[META_CATEGORY]);
+        days.push_back(dayOrNone(string(parts[META_DATE], lengths[META_DATE])));
+        store.add(line);
+    }
+
+    vector<uint8_t> storeImage = store.image(metadataSourceBytes(META_FILE));
+    if (writeMetadataStore(META_STORE_FILE, storeImage)) {
+        cout << "Metadata store: " << store.size() << " docs (" << storeImage.size() / 1024 << " KB)" << endl;
+    } else {
+        cout << "Warning: could not write doc_metadata.bin (the engine builds it at load)." << endl;
+    }
+
+    vector<uint8_t> image = buildCategoryIndex(fields);
+    ofstream catFile(BARREL_DIR + "categories.bin", ios::binary);
+    if (!catFile) return false;
+    catFile.write((char*)image.data(), image.size());
+
+    CategoryHeader header;
+    memcpy(&header, image.data(), sizeof(header));
+    cout << "Category postings: " << header.numCategories << " categories over " << fields.size()
+         << " docs (" << image.size() / 1024 << " KB)" << endl;
+
+    ofstream dateFile(DATES_FILE, ios::binary);
+    if (!dateFile) return false;
+    uint32_t numDocs = (uint32_t)days.size();
+    dateFile.write((char*)&numDocs, sizeof(numDocs));
+    dateFile.write((char*)days.data(), days.size() * sizeof(uint32_t));
+    size_t dated = days.size() - count(days.begin(), days.end(), NO_DATE);
+    cout << "Date column: " << dated << "/" << numDocs << " docs dated." << endl;
+    return true;
+}
+
+// Reads a legacy (v1) barrel back into per-word posting lists.
+// Returns false if the file is missing or is not a v1 barrel.
+bool readBarrelV1(const string& filename, vector<vector<Posting>>& barrelData) {
+    ifstream inFile(filename, ios::binary);
+    if (!inFile) return false;
+
+    uint32_t magic = 0;
+    inFile.read((char*)&magic, sizeof(magic));
+    if (magic == BARREL_MAGIC) {
+        cerr << "Error: " << filename << " is already a v2 barrel." << endl;
+        return false;
+    }
+    inFile.seekg(0);
+
+    vector<long long> offsets(WORDS_PER_BARREL, 0);
+    inFile.read((char*)offsets.data(), offsets.size() * sizeof(long long));
+
+    barrelData.assign(WORDS_PER_BARREL, {});
+    for (uint32_t i = 0; i < WORDS_PER_BARREL; ++i) {
+        if (offsets[i] == 0) continue;
+        inFile.seekg(offsets[i]);
+        uint32_t listSize;
+        inFile.read((char*)&listSize, sizeof(listSize));
+        barrelData[i].resize(listSize);
+        inFile.read((char*)barrelData[i].data(), listSize * sizeof(Posting));
+        if (inFile.gcount() != (streamsize)(listSize * sizeof(Posting))) {
+            cerr << "Error: truncated list for local word " << i << " in " << filename << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Rewrites existing v1 barrels as v2 without touching the inverted index
+int convertFromV1(string sourceDir) {
+    if (sourceDir.back() != '\\' && sourceDir.back() != '/') {
+        sourceDir += "\\";
+    }
+    cout << "Converting v1 barrels from " << sourceDir << endl;
+
+    // The new barrels have new offsets: lexicon.bin gets them (and df) as after a full build
+    vector<string> words;
+    {
+        LexiconView lexicon;
+        if (lexicon.open(LEXICON_FILE)) words = lexicon.words();
+    }
+    listOffsets.assign(words.size(), NO_LIST_OFFSET);
+    listDF.assign(words.size(), 0);
+
+    int converted = 0;
+    while (true) {
+        string src = sourceDir + "barrel_" + to_string(converted) + ".bin";
+        vector<vector<Posting>> barrelData;
+        if (!readBarrelV1(src, barrelData)) break;
+
+        cout << "Converting Barrel " << converted << "..." << endl;
+        for (size_t i = 0; i < barrelData.size(); ++i) {
+            size_t w = (size_t)converted * WORDS_PER_BARREL + i;
+            if (w < listDF.size()) listDF[w] = (uint32_t)barrelData[i].size();
+        }
+        writeBarrelV2(converted, barrelData);
+        remove((BARREL_DIR + "barrel_" + to_string(converted) + ".pos").c_str()); // v1 has no positions
+        converted++;
+    }
+
+    if (converted == 0) {
+        cerr << "Error: no v1 barrels found in " << sourceDir << endl;
+        return 1;
+    }
+    if (words.empty()) {
+        cerr << "Warning: lexicon.bin not found; its df and list offsets were not updated." << endl;
+    } else if (writeLexicon(LEXICON_FILE, words, listDF, listOffsets)) {
+        cout << "Lexicon updated with df and list offsets (" << words.size() << " words)." << endl;
+    } else {
+        cerr << "Warning: could not rewrite lexicon.bin; offsets not stored." << endl;
+    }
+
+    cout << "Success! Converted " << converted << " barrels." << endl;
+    return 0;
+}
+
 int main(int argc, char* argv[]) {
-    if (argc > 1) {
-        BARREL_DIR = argv[1];
-        // Ensure trailing slash
-        if (BARREL_DIR.back() != '\\' && BARREL_DIR.back() != '/') {
-            BARREL_DIR += "\\";
+    string convertDir = "";
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--format" && i + 1 < argc) {
+            string fmt = argv[++i];
+            BARREL_FORMAT = (fmt == "v1" || fmt == "1") ? 1 : 2;
+        } else if (arg == "--from-v1" && i + 1 < argc) {
+            convertDir = argv[++i];
+        } else {
+            BARREL_DIR = arg;
+            // Ensure trailing slash
+            if (BARREL_DIR.back() != '\\' && BARREL_DIR.back() != '/') {
+                BARREL_DIR += "\\";
+            }
         }
     }
-    cout << "Output Directory: " << BARREL_DIR << endl;
+    cout << "Output Directory: " << BARREL_DIR << " (format v" << BARREL_FORMAT << ")" << endl;
     createDir(BARREL_DIR);
 
+    if (BARREL_FORMAT == 2) {
+        if (loadDocStats()) {
+            cout << "Block-max bounds enabled (" << docLengths.size() << " docs, avgDL " << avgDL << ")" << endl;
+        } else {
+            cout << "Warning: doc_lengths.bin not found. Writing barrels without block-max bounds." << endl;
+        }
+    }
+
+    if (!writeMetadataColumns()) {
+        cout << "Warning: doc_metadata.txt not found. No categories.bin / doc_dates.bin (the engine builds them at load)." << endl;
+    }
+
+    if (!convertDir.empty()) {
+        if (convertDir == BARREL_DIR) {
+            cerr << "Error: --from-v1 needs a different output directory." << endl;
+            return 1;
+        }
+        return convertFromV1(convertDir);
+    }
+
     // 1. Get Lexicon Size (to know total words)
-    ifstream lexFile(LEXICON_FILE, ios::binary);
-    if (!lexFile) {
-        cerr << "Error: lexicon.bin not found. Run build_lexicon first." << endl;
-        return 1;
+    vector<string> words;
+    {
+        LexiconView lexicon;
+        if (!lexicon.open(LEXICON_FILE)) {
+            cerr << "Error: lexicon.bin not found. Run build_lexicon first." << endl;
+            return 1;
+        }
+        words = lexicon.words(); // Closed again before lexicon.bin is rewritten below
     }
-    uint32_t totalWords;
-    lexFile.read((char*)&totalWords, sizeof(totalWords));
-    lexFile.close();
+    uint32_t totalWords = (uint32_t)words.size();
+    listOffsets.assign(totalWords, NO_LIST_OFFSET);
+    listDF.assign(totalWords, 0);
 
     cout << "Total Words: " << totalWords << ". Batch Size: " << WORDS_PER_BARREL << endl;
 
@@ -112,6 +502,17 @@ int main(int argc, char* argv[]) {
     uint32_t checkTotal;
     invFile.read((char*)&checkTotal, sizeof(checkTotal));
 
+    // Optional positions, read in lockstep with the inverted index
+    ifstream posFile(INVERTED_POS_FILE, ios::binary);
+    bool withPositions = false;
+    if (posFile) {
+        uint32_t posTotal = 0;
+        posFile.read((char*)&posTotal, sizeof(posTotal));
+        withPositions = (posTotal == checkTotal);
+        if (withPositions) cout << "Positional index found: writing barrel_N.pos files." << endl;
+        else cerr << "Warning: inverted_positions.bin does not match the inverted index. Positions skipped." << endl;
+    }
+
     // 3. Sequential Processing (Barrel by Barrel)
     int currentBarrelID = 0;
     
@@ -129,6 +530,7 @@ int main(int argc, char* argv[]) {
 
         // In-Memory Storage for THIS Barrel only
         vector<vector<Posting>> barrelData(WORDS_PER_BARREL);
+        vector<vector<uint32_t>> barrelPositions(withPositions ? WORDS_PER_BARREL : 0);
 
         // Read from Inverted Index (Assumption: Inverted Index is sorted by WordID)
         // Since inverted_index.bin IS sorted by WordID 0...N (created by invert.cpp loop),
@@ -137,6 +539,7 @@ int main(int argc, char* argv[]) {
         for (uint32_t w = startWord; w < endWord; ++w) {
             uint32_t listSize;
             invFile.read((char*)&listSize, sizeof(listSize));
+            listDF[w] = listSize;
             
             if (listSize > 0) {
                 vector<Posting> postings(listSize);
@@ -151,15 +554,43 @@ int main(int argc, char* argv[]) {
                 // Store in local barrel buffer (0-indexed relative to barrel)
                 barrelData[w - startWord] = postings;
             }
+
+            if (withPositions) {
+                uint32_t numPositions = 0;
+                posFile.read((char*)&numPositions, sizeof(numPositions));
+                uint64_t expected = 0;
+                for (const Posting& p : barrelData[w - startWord]) expected += p.freq;
+                if (!posFile || numPositions != expected) {
+                    cerr << "Warning: positions of word " << w << " do not match its postings. Positions skipped." << endl;
+                    withPositions = false;
+                    barrelPositions.clear();
+                    // Drop the .pos files already written so no barrel mixes builds
+                    for (int b = 0; b < currentBarrelID; ++b) {
+                        remove((BARREL_DIR + "barrel_" + to_string(b) + ".pos").c_str());
+                    }
+                    continue;
+                }
+                vector<uint32_t>& pos = barrelPositions[w - startWord];
+                pos.resize(numPositions);
+                posFile.read((char*)pos.data(), numPositions * sizeof(uint32_t));
+            }
         }
 
         // Write to Disk
-        writeBarrel(currentBarrelID, barrelData);
+        writeBarrel(currentBarrelID, barrelData, withPositions ? &barrelPositions : nullptr);
 
         currentBarrelID++;
     }
 
     invFile.close();
+
+    // 4. df and list offsets go inline into lexicon.bin (v2)
+    if (writeLexicon(LEXICON_FILE, words, listDF, listOffsets)) {
+        cout << "Lexicon updated with df and list offsets (" << totalWords << " words)." << endl;
+    } else {
+        cerr << "Warning: could not rewrite lexicon.bin; offsets not stored." << endl;
+    }
+
     cout << "Success! Created " << currentBarrelID << " barrels." << endl;
     return 0;
 }
@@ -191,4 +622,29 @@ int main(int argc, char* argv[]) {
          - Seek to byte 2048.
          - Read the data.
        - This guarantees single-seek retrieval time, critical for speed.
+
+    4. FORMAT v2 (DEFAULT)
+       - Same offset table idea, but posting lists are delta + StreamVByte encoded
+         in blocks of 128 with a small block directory (see barrel_format.h).
+       - Each block also gets a score upper bound (best BM25 tf-part, best PageRank)
+         so the engine can skip blocks that cannot reach the top-k.
+       - Usage:
+           create_barrels [outDir]                     -> v2 barrels
+           create_barrels --format v1 [outDir]         -> legacy raw barrels
+           create_barrels --from-v1 <v1Dir> [outDir]   -> convert without re-inverting
+
+    5. POSITIONS (OPTIONAL)
+       - If inverted_positions.bin exists (forward_indexer --positions, then invert),
+         every barrel gets a barrel_N.pos next to it with VByte-coded term positions
+         for phrase and proximity queries (see position_format.h).
+       - --from-v1 has no positions to convert; rebuild with invert for those.
+
+    6. METADATA COLUMNS
+       - categories.bin (next to the barrels) holds one docID set per arXiv category
+         from doc_metadata.txt, so "/cat:" filters join the intersection instead of
+         string-matching every scored doc (see category_format.h).
+       - doc_dates.bin stores every doc's date as a day number for "/date" sorting
+         and "/since:" / "/until:" ranges (see date_format.h).
+       - doc_metadata.bin holds every metadata field as a column (offsets + string
+         pool) that the engine maps instead of parsing the text (see metadata_format.h).
 */
\ No newline at end of file
@@ -0,0 +1,82 @@
+#ifndef DATE_FORMAT_H
+#define DATE_FORMAT_H
+
+#include <string>
+#include <cstdint>
+#include <cstdlib>
+#include <cctype>
+
+using namespace std;
+
+// ---------------------------------------------------------
+// DATE COLUMN (doc_dates.bin, next to doc_lengths.bin)
+// ---------------------------------------------------------
+//   [numDocs: uint32][day: uint32 x numDocs]   (same layout as doc_lengths.bin)
+//
+// day = days since 1970-01-01 of the Date column of doc_metadata.txt
+// ("YYYY-MM-DD"), NO_DATE if it is missing or unparsable ("N/A"). Comparing
+// two integers replaces comparing two date strings, and a range filter is
+// one load and two compares per doc.
+
+const uint32_t NO_DATE = 0; // Sorts after every real date
+
+// Days since 1970-01-01 for a proleptic Gregorian date (H. Hinnant's algorithm)
+inline int64_t daysFromCivil(int64_t y, unsigned m, unsigned d) {
+    y -= m <= 2;
+    int64_t era = (y >= 0 ? y : y - 399) / 400;
+    unsigned yoe = (unsigned)(y - era * 400);
+    unsigned doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+    unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + (int64_t)doe - 719468;
+}
+
+inline bool isLeapYear(int64_t y) { return (y % 4 == 0 && y % 100 != 0) || y % 400 == 0; }
+
+inline unsigned daysInMonth(int64_t y, unsigned m) {
+    static const unsigned DAYS[12] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+    return (m == 2 && isLeapYear(y)) ? 29 : DAYS[m - 1];
+}
+
+// Parses "YYYY", "YYYY-MM" or "YYYY-MM-DD". A partial date is widened to the
+// first day of its period, or to the last one with 'endOfPeriod'
+// ("/until:2022" = up to 2022-12-31). Returns false on anything else.
+inline bool parseDay(const string& s, bool endOfPeriod, uint32_t& day) {
+    if (s.size() != 4 && s.size() != 7 && s.size() != 10) return false;
+    for (size_t i = 0; i < s.size(); ++i) {
+        bool dash = (i == 4 || i == 7);
+        if (dash ? s[i] != '-' : !isdigit((unsigned char)s[i])) return false;
+    }
+
+    int64_t y = atoi(s.substr(0, 4).c_str());
+    unsigned m = (s.size() >= 7) ? (unsigned)atoi(s.substr(5, 2).c_str()) : (endOfPeriod ? 12 : 1);
+    if (m < 1 || m > 12) return false;
+    unsigned d = (s.size() == 10) ? (unsigned)atoi(s.substr(8, 2).c_str()) : (endOfPeriod ? daysInMonth(y, m) : 1);
+    if (d < 1 || d > daysInMonth(y, m)) return false;
+
+    int64_t days = daysFromCivil(y, m, d);
+    if (days <= (int64_t)NO_DATE || days > (int64_t)UINT32_MAX) return false;
+    day = (uint32_t)days;
+    return true;
+}
+
+// Date column value for one metadata field
+inline uint32_t dayOrNone(const string& field) {
+    uint32_t day;
+    return parseDay(field, false, day) ? day : NO_DATE;
+}
+
+#endif
+
+/*
+    ========================================================================================
+    EDUCATIONAL SUMMARY: DATE COLUMN
+    ========================================================================================
+
+    1. WHY INTEGERS?
+       - "/date" sorting used to copy and compare two date strings per comparison.
+       - A day number is 4 bytes, compares in one instruction and makes ranges
+         ("/since:2022", "/until:2023-06") trivial to test during intersection.
+
+    2. COLUMN LAYOUT
+       - Same shape as doc_lengths.bin, so it loads with a single read next to it.
+*/
@@ -4,50 +4,211 @@
 #include <vector>
 #include <unordered_map>
 #include <map>
+#include <algorithm>
+#include <thread>
 #include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
 #include "common.h" // <--- INCLUDES STOPWORDS & TOKENIZER
+#include "lexicon_format.h"
+#include "chunk_reader.h"
+#include "bounded_queue.h"
 
 using namespace std;
 
-// This Lexicon class is for LOADING (Reading), not building
-class LexiconLoader {
+const string POSITIONS_FILE = "C:\\Users\\Hank47\\Sem3\\Rummager\\forward_positions.bin";
+const string LEXICON_FILE = "C:\\Users\\Hank47\\Sem3\\Rummager\\lexicon.bin";
+
+// --- CONFIGURATION ---
+const size_t CHUNK_BYTES = 1 << 20; // Whole lines handed to one worker at a time
+const size_t CHUNKS_PER_WORKER = 4; // Chunks read ahead / waiting for the writer, per worker
+
+// --build-lexicon: word IDs handed out on first sight, in this same pass.
+// build_lexicon numbers words in the order they first appear in
+// clean_dataset.txt and counts df once per line; doing exactly that here
+// gives the same lexicon.bin, and because a doc's words all have their final
+// IDs by the time it is written, the same forward records too.
+// Workers number the words of their chunk locally; the writer merges chunks
+// in file order, which hands out global IDs in the order a single pass would.
+class FirstSightLexicon {
 private:
-    unordered_map<string, int> wordToID;
+    unordered_map<string, uint32_t> ids;
 
 public:
-    bool loadBinary(const string& filename) {
-        ifstream inFile(filename, ios::binary);
-        if (!inFile) return false;
-
-        uint32_t size;
-        inFile.read((char*)&size, sizeof(size));
-
-        for (uint32_t i = 0; i < size; ++i) {
-            uint32_t len;
-            inFile.read((char*)&len, sizeof(len));
-            string word(len, ' ');
-            inFile.read(&word[0], len);
-            wordToID[word] = i; 
+    vector<string> words;
+    vector<uint32_t> docFreq;
+
+    uint32_t add(string& word, uint32_t df) {
+        auto [it, fresh] = ids.try_emplace(word, (uint32_t)words.size());
+        if (fresh) {
+            words.push_back(move(word));
+            docFreq.push_back(0);
         }
-        return true;
+        docFreq[it->second] += df;
+        return it->second;
     }
+};
 
-    int getID(const string& word) const {
-        auto it = wordToID.find(word);
-        return (it != wordToID.end()) ? it->second : -1;
+// One doc of a chunk: its tokens' word IDs (with positions) still to be counted
+struct PendingDoc {
+    uint32_t docID;
+    size_t begin, end; // Range in ChunkResult::keys
+};
+
+// What a worker hands the writer for one chunk. With a lexicon.bin the
+// records are already encoded; with --build-lexicon they carry chunk-local
+// word IDs that only the writer can turn into global ones.
+struct ChunkResult {
+    uint64_t seq = 0;
+    string forward;   // forward_index.bin bytes
+    string positions; // forward_positions.bin bytes (--positions)
+    vector<pair<uint32_t, uint32_t>> lengths; // (docID, total words), in file order
+
+    vector<string> localWords;   // --build-lexicon: new-to-this-chunk words, first-seen order
+    vector<uint32_t> localDf;
+    vector<PendingDoc> docs;
+    vector<uint64_t> keys;       // (local wordID << 32 | position)
+};
+
+void appendU32(string& out, uint32_t v) { out.append((const char*)&v, sizeof(v)); }
+
+// Counts one doc's (wordID << 32 | position) keys and appends its records.
+// Sorting the keys groups each word's positions, already in order, so a
+// run is one (wordID, freq) pair: no map per doc, no allocation once warm.
+void encodeDoc(uint32_t docID, uint64_t* keys, size_t n, bool withPositions, string& forward, string& positions) {
+    sort(keys, keys + n);
+    uint32_t unique = 0;
+    for (size_t i = 0; i < n; ++i) unique += (i == 0 || (keys[i] >> 32) != (keys[i - 1] >> 32));
+
+    appendU32(forward, docID);
+    appendU32(forward, (uint32_t)n);
+    appendU32(forward, unique);
+    for (size_t i = 0; i < n;) {
+        size_t run = i + 1;
+        while (run < n && (keys[run] >> 32) == (keys[i] >> 32)) run++;
+        appendU32(forward, (uint32_t)(keys[i] >> 32));
+        appendU32(forward, (uint32_t)(run - i));
+        i = run;
     }
-    
-    size_t size() const { return wordToID.size(); }
+
+    // Positions: same word order as the record above
+    if (withPositions) {
+        appendU32(positions, docID);
+        appendU32(positions, (uint32_t)n);
+        for (size_t i = 0; i < n; ++i) appendU32(positions, (uint32_t)keys[i]);
+    }
+}
+
+struct IndexerSettings {
+    const unordered_map<string, uint32_t>* idMap;
+    const LexiconView* lexicon; // Unused with --build-lexicon
+    bool withPositions;
+    bool buildLexicon;
 };
 
-int main() {
-    LexiconLoader lexicon;
-    if (!lexicon.loadBinary("C:\\Users\\Hank47\\Sem3\\Rummager\\lexicon.bin")) {
-        cerr << "Error: lexicon.bin missing. Run builder first." << endl;
+// Worker stage: tokenizes every "ID\tcontent" line of a chunk and counts it
+void indexChunk(const string& text, const IndexerSettings& settings, ChunkResult& out) {
+    Tokenizer tokenizer;
+    string key;            // Reused: id_map and local-vocab lookups
+    vector<uint64_t> keys; // Reused per doc (lexicon.bin mode)
+    unordered_map<string, uint32_t> local; // --build-lexicon
+    vector<uint32_t> lastLine;
+    uint32_t lineNo = 0;
+
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t end = text.find('\n', pos);
+        if (end == string::npos) end = text.size();
+        // input format: DocIDVal <tab> Content...
+        const char* tab = (const char*)memchr(text.data() + pos, '\t', end - pos);
+        if (!tab) {
+            pos = end + 1;
+            continue;
+        }
+        uint32_t thisLine = lineNo++;
+        key.assign(text.data() + pos, tab);
+        string_view content(tab + 1, (size_t)(text.data() + end - (tab + 1)));
+        pos = end + 1;
+
+        // Resolve ID. Not in the map (preprocessed file has more docs than the
+        // graph?): skipped to match graph consistency, but its words still
+        // count for the lexicon, as they do in build_lexicon.
+        auto mapped = settings.idMap->find(key);
+        bool indexed = (mapped != settings.idMap->end());
+        if (!indexed && !settings.buildLexicon) continue;
+
+        const vector<string_view>& tokens = tokenizer.tokenize(content);
+
+        if (settings.buildLexicon) {
+            size_t begin = out.keys.size();
+            for (size_t t = 0; t < tokens.size(); ++t) {
+                key.assign(tokens[t].data(), tokens[t].size());
+                auto [it, fresh] = local.try_emplace(key, (uint32_t)out.localWords.size());
+                if (fresh) {
+                    out.localWords.push_back(key);
+                    out.localDf.push_back(0);
+                    lastLine.push_back(UINT32_MAX);
+                }
+                uint32_t id = it->second;
+                if (lastLine[id] != thisLine) {
+                    lastLine[id] = thisLine;
+                    out.localDf[id]++;
+                }
+                if (indexed) out.keys.push_back(((uint64_t)id << 32) | t);
+            }
+            if (indexed) out.docs.push_back({ mapped->second, begin, out.keys.size() });
+            continue;
+        }
+
+        keys.clear();
+        for (size_t t = 0; t < tokens.size(); ++t) {
+            int id = settings.lexicon->find(tokens[t].data(), tokens[t].size());
+            if (id != -1) keys.push_back(((uint64_t)id << 32) | t);
+        }
+        encodeDoc(mapped->second, keys.data(), keys.size(), settings.withPositions, out.forward, out.positions);
+        out.lengths.push_back({ mapped->second, (uint32_t)keys.size() });
+    }
+}
+
+// Writer stage, --build-lexicon: local IDs -> global ones (new words get the
+// next IDs in the chunk's first-seen order), then the records as usual
+void finishChunk(ChunkResult& chunk, FirstSightLexicon& lexicon, bool withPositions) {
+    vector<uint32_t> globalID(chunk.localWords.size());
+    for (size_t i = 0; i < chunk.localWords.size(); ++i) globalID[i] = lexicon.add(chunk.localWords[i], chunk.localDf[i]);
+
+    for (const PendingDoc& doc : chunk.docs) {
+        for (size_t k = doc.begin; k < doc.end; ++k) {
+            uint64_t& key = chunk.keys[k];
+            key = ((uint64_t)globalID[key >> 32] << 32) | (uint32_t)key;
+        }
+        encodeDoc(doc.docID, chunk.keys.data() + doc.begin, doc.end - doc.begin, withPositions,
+                  chunk.forward, chunk.positions);
+        chunk.lengths.push_back({ doc.docID, (uint32_t)(doc.end - doc.begin) });
+    }
+}
+
+int main(int argc, char* argv[]) {
+    // --positions: also record where each word occurs (for phrase queries).
+    // Written to a side file; forward_index.bin keeps its exact format.
+    bool withPositions = false;
+    bool buildLexicon = false; // --build-lexicon: no separate build_lexicon pass needed
+    size_t threads = max(thread::hardware_concurrency(), 1u); // --threads N: tokenizer workers
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--positions") withPositions = true;
+        if (arg == "--build-lexicon") buildLexicon = true;
+        if (arg == "--threads" && i + 1 < argc) threads = max(atoi(argv[++i]), 1);
+    }
+
+    LexiconView lexicon; // Mapped, looked up through its perfect hash
+    FirstSightLexicon freshLexicon;
+    if (!buildLexicon && !lexicon.open(LEXICON_FILE)) {
+        cerr << "Error: lexicon.bin missing. Run builder first (or use --build-lexicon)." << endl;
         return 1;
     }
 
-    ifstream infile("C:\\Users\\Hank47\\Sem3\\Rummager\\clean_dataset.txt");
+    ifstream infile("C:\\Users\\Hank47\\Sem3\\Rummager\\clean_dataset.txt", ios::binary);
     if (!infile) {
         cerr << "Error: clean_dataset.txt not found." << endl;
         return 1;
@@ -72,68 +233,87 @@ int main() {
 
     ofstream outfile("C:\\Users\\Hank47\\Sem3\\Rummager\\forward_index.bin", ios::binary);
     ofstream lenFile("C:\\Users\\Hank47\\Sem3\\Rummager\\doc_lengths.bin", ios::binary);
+
+    ofstream posFile;
+    if (withPositions) {
+        posFile.open(POSITIONS_FILE, ios::binary);
+        cout << "Recording term positions -> forward_positions.bin" << endl;
+    } else {
+        remove(POSITIONS_FILE.c_str()); // A stale side file would no longer match
+    }
     
     // We need random access to lengths now, so use a vector
     vector<uint32_t> lengthsBuffer(maxID + 1, 0);
 
-    string line;
-    uint32_t docsProcessed = 0;
+    cout << "Starting Forward Indexing (" << threads << " workers"
+         << (buildLexicon ? ", assigning word IDs" : "") << ")..." << endl;
 
-    cout << "Starting Forward Indexing..." << endl;
+    // --- PIPELINE: reader -> N workers -> writer (this thread, file order) ---
+    IndexerSettings settings = { &idMap, &lexicon, withPositions, buildLexicon };
+    size_t window = threads * CHUNKS_PER_WORKER;
+    BoundedQueue<pair<uint64_t, string>> toWorkers(window);
+    BoundedQueue<ChunkResult> toWriter(window);
+    BoundedQueue<bool> inFlight(window); // One token per chunk not yet written: caps memory
 
-    while (getline(infile, line)) {
-        // input format: DocIDVal <tab> Content...
-        size_t tabPos = line.find('\t');
-        if (tabPos == string::npos) continue;
-
-        string docIDStr = line.substr(0, tabPos);
-        string content = line.substr(tabPos + 1);
-
-        // Resolve ID
-        if (idMap.find(docIDStr) == idMap.end()) {
-            // If not found in map (maybe preprocessed file has more docs than graph?), skip or warn
-            // For now, skip to match graph consistency
-            continue;
+    thread reader([&] {
+        string carry;
+        for (uint64_t seq = 0;; ++seq) {
+            inFlight.push(true);
+            vector<string> chunk = readChunks(infile, carry, 1, CHUNK_BYTES);
+            if (chunk.empty()) break;
+            toWorkers.push({ seq, move(chunk[0]) });
         }
-        uint32_t uDocID = idMap[docIDStr];
+        toWorkers.close();
+    });
 
-        vector<string> tokens = Tokenize::tokenize(content);
-
-        // Map: WordID -> Frequency
-        map<int, int> docWordFreq;
-        int totalWordsInDoc = 0;
-
-        for (const string& token : tokens) {
-            int id = lexicon.getID(token);
-            if (id != -1) {
-                docWordFreq[id]++;
-                totalWordsInDoc++;
+    vector<thread> workers;
+    for (size_t w = 0; w < threads; ++w) {
+        workers.emplace_back([&] {
+            pair<uint64_t, string> chunk;
+            while (toWorkers.pop(chunk)) {
+                ChunkResult result;
+                result.seq = chunk.first;
+                indexChunk(chunk.second, settings, result);
+                toWriter.push(move(result));
             }
-        }
+        });
+    }
+    thread closer([&] {
+        for (thread& t : workers) t.join();
+        toWriter.close();
+    });
 
-        // Write to Forward Index
-        uint32_t uTotal = (uint32_t)totalWordsInDoc;
-        uint32_t uUnique = (uint32_t)docWordFreq.size();
+    // Chunks finish out of order; each is written once all before it are
+    map<uint64_t, ChunkResult> waiting;
+    uint64_t nextSeq = 0;
+    uint32_t docsProcessed = 0;
+    ChunkResult done;
+    while (toWriter.pop(done)) {
+        uint64_t seq = done.seq;
+        waiting.emplace(seq, move(done));
+        for (auto it = waiting.begin(); it != waiting.end() && it->first == nextSeq; it = waiting.erase(it), ++nextSeq) {
+            ChunkResult& chunk = it->second;
+            if (buildLexicon) finishChunk(chunk, freshLexicon, withPositions);
 
-        outfile.write((char*)&uDocID, sizeof(uDocID));
-        outfile.write((char*)&uTotal, sizeof(uTotal));
-        outfile.write((char*)&uUnique, sizeof(uUnique));
+            // Write to Forward Index: one write per chunk
+            outfile.write(chunk.forward.data(), (streamsize)chunk.forward.size());
+            if (withPositions) posFile.write(chunk.positions.data(), (streamsize)chunk.positions.size());
 
-        for (const auto& pair : docWordFreq) {
-            uint32_t uWordID = (uint32_t)pair.first;
-            uint32_t uFreq = (uint32_t)pair.second;
-            outfile.write((char*)&uWordID, sizeof(uWordID));
-            outfile.write((char*)&uFreq, sizeof(uFreq));
-        }
+            // Store Length (a repeated docID keeps its last line's, as before)
+            for (const auto& [docID, total] : chunk.lengths) {
+                if (docID < lengthsBuffer.size()) lengthsBuffer[docID] = total;
+            }
 
-        // Store Length
-        if (uDocID < lengthsBuffer.size()) {
-            lengthsBuffer[uDocID] = uTotal;
-        }
+            uint32_t before = docsProcessed;
+            docsProcessed += (uint32_t)chunk.lengths.size();
+            if (docsProcessed / 1000 != before / 1000) cout << "Indexed " << docsProcessed << " docs...\r" << flush;
 
-        docsProcessed++;
-        if (docsProcessed % 1000 == 0) cout << "Indexed " << docsProcessed << " docs...\r" << flush;
+            bool token;
+            inFlight.pop(token);
+        }
     }
+    reader.join();
+    closer.join();
 
     // Write Lengths File
     uint32_t totalDocs = lengthsBuffer.size();
@@ -143,6 +323,16 @@ int main() {
     infile.close();
     outfile.close();
     lenFile.close();
+    if (withPositions) posFile.close();
+
+    // Lexicon v2 (lexicon_format.h); list offsets are filled in by create_barrels
+    if (buildLexicon) {
+        if (!writeLexicon(LEXICON_FILE, freshLexicon.words, freshLexicon.docFreq)) {
+            cerr << "Error writing lexicon.bin" << endl;
+            return 1;
+        }
+        cout << "\nSaved lexicon.bin (" << freshLexicon.words.size() << " words).";
+    }
 
     cout << "\nIndex Complete! Processed " << docsProcessed << " documents. Mapped to " << totalDocs << " IDs." << endl;
     return 0;
@@ -162,10 +352,31 @@ int main() {
        - Document Length (DL): Total words in the doc. Crucial for BM25 Normalization.
     
     3. DATA STRUCTURE
-       - We use a Hash Map (`map<int, int> docWordFreq`) per document to count frequencies.
-       - We write to disk immediately to keep RAM usage low (Stream Processing).
+       - Each token becomes one 64-bit key (wordID << 32 | position). Sorting a doc's
+         keys puts every word's occurrences side by side, so term frequencies are
+         run lengths; the key buffer is reused, where a map per doc allocated a node
+         per distinct word.
+       - Records are appended to a per-chunk buffer and written in one call, and
+         only a bounded number of chunks is ever held (Stream Processing).
+       - With "--positions", each word's token positions go to forward_positions.bin
+         (same doc/word order), the input for phrase queries. See position_format.h.
     
-    4. WHY "FORWARD" FIRST?
+    4. ONE PASS ("--build-lexicon")
+       - Normally build_lexicon tokenizes the whole corpus to number the words and
+         this tool tokenizes it all again. With --build-lexicon, IDs are assigned
+         here on first sight, in the order build_lexicon would use, so lexicon.bin
+         and the forward index come out identical while the corpus is read and
+         tokenized once.
+
+    5. PIPELINE ("--threads N", default = all cores)
+       - A reader thread cuts the input into 1 MB chunks of whole lines, N workers
+         tokenize and count them, and the main thread writes finished chunks in
+         file order. The output is the same bytes whatever N is.
+       - With --build-lexicon, workers number words per chunk and the writer turns
+         those into global IDs chunk by chunk, in file order: the only part that
+         must stay serial.
+
+    6. WHY "FORWARD" FIRST?
        - We cannot build the Inverted Index directly because we process docs one by one.
        - We first build the Forward Index (Doc-centric), then "Invert" it (Word-centric).
 */
\ No newline at end of file
@@ -1,8 +1,14 @@
 #include <iostream>
 #include <fstream>
 #include <vector>
+#include <string>
+#include <queue>
+#include <functional>
 #include <cstdint>
+#include <cstdlib>
 #include <algorithm> // Needed for max()
+#include <cstdio>
+#include "lexicon_format.h"
 
 using namespace std;
 
@@ -11,59 +17,103 @@ struct Posting {
     uint32_t freq;
 };
 
-int main() {
-    // --- PATHS ---
-    const string FORWARD_FILE = "C:\\Users\\Hank47\\Sem3\\Rummager\\forward_index.bin";
-    const string LEXICON_FILE = "C:\\Users\\Hank47\\Sem3\\Rummager\\lexicon.bin";
-    const string OUTPUT_FILE  = "C:\\Users\\Hank47\\Sem3\\Rummager\\inverted_index.bin";
-    
-    // 1. Get Lexicon Size
-    ifstream lexFile(LEXICON_FILE, ios::binary);
-    if (!lexFile) { cerr << "Error: " << LEXICON_FILE << " missing." << endl; return 1; }
-    
-    uint32_t totalWords;
-    lexFile.read((char*)&totalWords, sizeof(totalWords));
-    lexFile.close();
+// --- FORWARD INDEX READER ---
+// One doc at a time. Positions are read in lockstep with the forward index;
+// any mismatch (e.g. a side file from an older run) drops positions
+// altogether, and a doc's positions are only handed out once its
+// frequencies have been checked against them.
+class ForwardReader {
+private:
+    ifstream fwdFile;
+    ifstream posFile;
+    bool withPositions = false;
 
-    cout << "Initializing Indexer for " << totalWords << " words..." << endl;
+    void dropPositions(const string& why) {
+        cerr << "Warning: " << why << " Positions skipped." << endl;
+        withPositions = false;
+        positions.clear();
+    }
 
-    // 2. Prepare Memory
-    vector<vector<Posting>> invertedIndex(totalWords);
-    
-    ifstream fwdFile(FORWARD_FILE, ios::binary);
-    if (!fwdFile) { cerr << "Error: " << FORWARD_FILE << " missing." << endl; return 1; }
+public:
+    uint32_t docID = 0;
+    vector<pair<uint32_t, uint32_t>> words; // (wordID, freq), as stored
+    vector<uint32_t> positions;             // Per word, in the order of 'words'
 
-    uint32_t docID, totalDocWords, uniqueCount;
-    uint32_t wordID, freq;
-    int docsProcessed = 0;
+    bool open(const string& forwardPath, const string& positionsPath) {
+        fwdFile.open(forwardPath, ios::binary);
+        posFile.open(positionsPath, ios::binary);
+        withPositions = (bool)posFile;
+        return (bool)fwdFile;
+    }
 
-    cout << "Reading Forward Index..." << endl;
+    bool hasPositions() const { return withPositions; }
 
-    while (fwdFile.read((char*)&docID, sizeof(docID))) {
+    bool next() {
+        uint32_t totalDocWords, uniqueCount;
+        if (!fwdFile.read((char*)&docID, sizeof(docID))) return false;
         fwdFile.read((char*)&totalDocWords, sizeof(totalDocWords));
         fwdFile.read((char*)&uniqueCount, sizeof(uniqueCount));
 
+        if (withPositions) {
+            uint32_t posDocID = 0, posCount = 0;
+            posFile.read((char*)&posDocID, sizeof(posDocID));
+            posFile.read((char*)&posCount, sizeof(posCount));
+            if (!posFile || posDocID != docID || posCount != totalDocWords) {
+                dropPositions("forward_positions.bin does not match the forward index.");
+            } else {
+                positions.resize(posCount);
+                posFile.read((char*)positions.data(), posCount * sizeof(uint32_t));
+            }
+        }
+
+        words.resize(uniqueCount);
+        uint64_t posUsed = 0;
         for (uint32_t i = 0; i < uniqueCount; ++i) {
-            fwdFile.read((char*)&wordID, sizeof(wordID));
-            fwdFile.read((char*)&freq, sizeof(freq));
+            fwdFile.read((char*)&words[i].first, sizeof(uint32_t));
+            fwdFile.read((char*)&words[i].second, sizeof(uint32_t));
+            posUsed += words[i].second;
+        }
+        if (withPositions && posUsed != positions.size()) {
+            dropPositions("positions of doc " + to_string(docID) + " do not match its frequencies.");
+        }
+        return true;
+    }
+};
 
+// --- IN-MEMORY INVERSION (default) ---
+// Every posting list in RAM, then written in one go
+void invertInMemory(ForwardReader& reader, uint32_t totalWords, ofstream& outFile, ofstream& outPos) {
+    // 2. Prepare Memory
+    vector<vector<Posting>> invertedIndex(totalWords);
+    vector<vector<uint32_t>> invertedPositions(reader.hasPositions() ? totalWords : 0);
+    int docsProcessed = 0;
+
+    cout << "Reading Forward Index..." << endl;
+
+    while (reader.next()) {
+        if (!reader.hasPositions() && !invertedPositions.empty()) {
+            invertedPositions.clear();
+            invertedPositions.shrink_to_fit();
+        }
+        size_t posUsed = 0;
+        for (const auto& [wordID, freq] : reader.words) {
             if (wordID < totalWords) {
-                invertedIndex[wordID].push_back({docID, freq});
+                invertedIndex[wordID].push_back({reader.docID, freq});
+                if (reader.hasPositions()) {
+                    invertedPositions[wordID].insert(invertedPositions[wordID].end(),
+                                                     reader.positions.begin() + posUsed,
+                                                     reader.positions.begin() + posUsed + freq);
+                }
             }
+            posUsed += freq;
         }
 
         docsProcessed++;
         if (docsProcessed % 10000 == 0) cout << "Processed " << docsProcessed << " docs...\r" << flush;
     }
-    fwdFile.close();
 
     // 3. Write INVERTED INDEX to Disk
     cout << "\nWriting Inverted Index..." << endl;
-    ofstream outFile(OUTPUT_FILE, ios::binary);
-    
-    // Header
-    outFile.write((char*)&totalWords, sizeof(totalWords));
-
     for (uint32_t i = 0; i < totalWords; ++i) {
         uint32_t listSize = (uint32_t)invertedIndex[i].size();
         outFile.write((char*)&listSize, sizeof(listSize));
@@ -71,7 +121,408 @@ int main() {
             outFile.write((char*)invertedIndex[i].data(), listSize * sizeof(Posting));
         }
     }
+
+    // 4. Positions, same word order and posting order as above
+    if (reader.hasPositions()) {
+        cout << "Writing Inverted Positions..." << endl;
+        for (uint32_t i = 0; i < totalWords; ++i) {
+            uint32_t numPositions = (uint32_t)invertedPositions[i].size();
+            outPos.write((char*)&numPositions, sizeof(numPositions));
+            outPos.write((char*)invertedPositions[i].data(), numPositions * sizeof(uint32_t));
+        }
+    }
+}
+
+// --- EXTERNAL-MEMORY INVERSION ("--mem-budget MB") ---
+// Postings are collected in a flat buffer until the budget is reached, then
+// grouped by word (a counting sort, stable, so each word keeps forward-index
+// order) and flushed as a sorted run:
+//   per word present: [wordID][n][Posting x n][m][position x m]
+// The runs are then merged word by word. For one word, earlier runs hold
+// earlier docs, so taking runs in order gives the same lists, byte for
+// byte, as the in-memory path.
+
+struct RunPosting {
+    uint32_t wordID;
+    uint32_t docID;
+    uint32_t freq;
+    uint32_t posBegin; // Into the run's positions (only while positions are kept)
+};
+
+const size_t RUN_ENTRY_BYTES = sizeof(RunPosting) + sizeof(uint32_t); // Entry + its slot in the sort order
+const size_t COPY_BUFFER_BYTES = 256 << 10;  // Staging for run writes and merge copies
+const size_t MAX_MERGE_FANIN = 256;          // Runs open at once (Windows' C runtime allows 512 files)
+const size_t MAX_RUN_POSITIONS = 1u << 31;   // Positions are 32-bit offsets into the run
+
+class RunWriter {
+private:
+    vector<RunPosting> entries;
+    vector<uint32_t> positions;
+    vector<uint32_t> order;       // Entries grouped by word
+    vector<uint32_t> wordOffsets; // Counting sort, reused across runs
+    string buffer;
+    size_t entryCapacity = 0;
+    size_t positionCapacity = 0;
+
+    // Staged through 'buffer', which never holds more than COPY_BUFFER_BYTES,
+    // even in the middle of one word's postings or positions
+    void emit(ofstream& out, const void* data, size_t bytes) {
+        if (buffer.size() + bytes > COPY_BUFFER_BYTES) {
+            out.write(buffer.data(), (streamsize)buffer.size());
+            buffer.clear();
+        }
+        if (bytes >= COPY_BUFFER_BYTES) out.write((const char*)data, (streamsize)bytes);
+        else buffer.append((const char*)data, bytes);
+    }
+    void emit(ofstream& out, uint32_t v) { emit(out, &v, sizeof(v)); }
+
+public:
+    vector<string> files;
+
+    // Everything is allocated here, once: adding never grows a vector past
+    // 'runBudget' (half of it for positions when there are any)
+    RunWriter(uint32_t totalWords, size_t runBudget, bool withPositions) : wordOffsets(totalWords + 1) {
+        size_t entryBudget = withPositions ? runBudget / 2 : runBudget;
+        entryCapacity = max(entryBudget / RUN_ENTRY_BYTES, (size_t)1);
+        positionCapacity = withPositions ? min((runBudget - entryBudget) / sizeof(uint32_t), MAX_RUN_POSITIONS) : 0;
+        entries.reserve(entryCapacity);
+        order.reserve(entryCapacity);
+        positions.reserve(positionCapacity);
+        buffer.reserve(COPY_BUFFER_BYTES);
+    }
+
+    bool empty() const { return entries.empty(); }
+
+    // Room for one more posting with 'freq' positions? A posting bigger than a
+    // whole empty run is still taken (the only case a vector may grow).
+    bool fits(uint32_t freq, bool withPositions) const {
+        if (entries.empty()) return true;
+        if (entries.size() >= entryCapacity) return false;
+        return !withPositions || positions.size() + freq <= positionCapacity;
+    }
+
+    void add(uint32_t wordID, uint32_t docID, uint32_t freq, const uint32_t* pos) {
+        entries.push_back({ wordID, docID, freq, (uint32_t)positions.size() });
+        if (pos) positions.insert(positions.end(), pos, pos + freq);
+    }
+
+    bool flush(const string& path, bool withPositions) {
+        fill(wordOffsets.begin(), wordOffsets.end(), 0);
+        for (const RunPosting& e : entries) wordOffsets[e.wordID + 1]++;
+        for (size_t w = 1; w < wordOffsets.size(); ++w) wordOffsets[w] += wordOffsets[w - 1];
+        order.resize(entries.size());
+        for (uint32_t i = 0; i < entries.size(); ++i) order[wordOffsets[entries[i].wordID]++] = i;
+
+        ofstream out(path, ios::binary);
+        if (!out) return false;
+        files.push_back(path); // Removed with the others, even if this write fails
+        for (size_t i = 0; i < order.size();) {
+            uint32_t wordID = entries[order[i]].wordID;
+            size_t end = i;
+            uint32_t numPositions = 0;
+            while (end < order.size() && entries[order[end]].wordID == wordID) {
+                numPositions += withPositions ? entries[order[end]].freq : 0;
+                end++;
+            }
+            emit(out, wordID);
+            emit(out, (uint32_t)(end - i));
+            for (size_t k = i; k < end; ++k) {
+                emit(out, entries[order[k]].docID);
+                emit(out, entries[order[k]].freq);
+            }
+            emit(out, numPositions);
+            if (withPositions) {
+                for (size_t k = i; k < end; ++k) {
+                    const RunPosting& e = entries[order[k]];
+                    emit(out, positions.data() + e.posBegin, e.freq * sizeof(uint32_t));
+                }
+            }
+            i = end;
+        }
+        out.write(buffer.data(), (streamsize)buffer.size());
+        buffer.clear();
+        out.close();
+        if (!out) return false;
+
+        entries.clear();
+        positions.clear();
+        return true;
+    }
+};
+
+// Streams one run back, one word block at a time. Every read is checked: a
+// run that ends early or can't be opened fails the whole merge.
+class RunReader {
+private:
+    ifstream in;
+
+public:
+    uint32_t wordID = 0;
+    bool failed = false;
+
+    bool open(const string& path) {
+        in.open(path, ios::binary);
+        if (!in) {
+            failed = true;
+            return false;
+        }
+        return advance();
+    }
+
+    // Reads the next block's word; false at the end of the run (or on a
+    // partial word, which also sets 'failed')
+    bool advance() {
+        if (in.read((char*)&wordID, sizeof(wordID))) return true;
+        failed = failed || in.gcount() != 0 || in.bad();
+        return false;
+    }
+
+    bool readCount(uint32_t& n) {
+        if (!in.read((char*)&n, sizeof(n))) failed = true;
+        return !failed;
+    }
+
+    // Copies (or skips, if 'out' is null) the next 'count' uint32s
+    bool pass(uint64_t count, ostream* out, vector<char>& copyBuffer) {
+        uint64_t bytes = count * sizeof(uint32_t);
+        while (bytes > 0 && !failed) {
+            size_t step = (size_t)min<uint64_t>(bytes, copyBuffer.size());
+            if (!in.read(copyBuffer.data(), step)) failed = true;
+            else if (out) out->write(copyBuffer.data(), step);
+            bytes -= step;
+        }
+        return !failed;
+    }
+};
+
+// Merges runs (in run order) word by word. For each word present in any run:
+//   postings  -> [count][Posting ...]      (into 'postingsOut')
+//   positions -> [count][position ...]     (into 'positionsOut'; skipped if null)
+// Intermediate passes write run blocks, so both go to one stream and each
+// block starts with its wordID; the final pass ('expected' != null) writes
+// every word 0..totalWords-1, empty ones too, into the two index files, and
+// checks each count against what was tallied while reading.
+struct WordCounts {
+    const vector<uint32_t>* listSizes;
+    const vector<uint32_t>* positionCounts; // Null when positions were dropped
+};
+
+bool mergeRuns(const vector<string>& files, uint32_t totalWords, ostream& postingsOut, ostream* positionsOut,
+               const WordCounts* expected) {
+    vector<RunReader> readers(files.size());
+    priority_queue<pair<uint32_t, size_t>, vector<pair<uint32_t, size_t>>, greater<>> heads;
+    for (size_t r = 0; r < readers.size(); ++r) {
+        if (readers[r].open(files[r])) heads.push({ readers[r].wordID, r });
+        if (readers[r].failed) {
+            cerr << "Error: could not read " << files[r] << endl;
+            return false;
+        }
+    }
+
+    vector<char> copyBuffer(COPY_BUFFER_BYTES);
+    vector<size_t> blocks; // Runs holding the current word, earliest run first
+    uint32_t w = 0;
+    while (expected ? w < totalWords : !heads.empty()) {
+        if (!expected) w = heads.top().first;
+        blocks.clear();
+        while (!heads.empty() && heads.top().first == w) {
+            blocks.push_back(heads.top().second);
+            heads.pop();
+        }
+
+        // Counts come first: read every block's before copying any postings
+        uint64_t n = 0, m = 0;
+        vector<uint32_t> counts(blocks.size());
+        for (size_t b = 0; b < blocks.size(); ++b) {
+            if (!readers[blocks[b]].readCount(counts[b])) {
+                cerr << "Error: " << files[blocks[b]] << " is truncated or unreadable." << endl;
+                return false;
+            }
+            n += counts[b];
+        }
+        if (expected && n != (*expected->listSizes)[w]) {
+            cerr << "Error: runs hold " << n << " postings for word " << w << ", expected "
+                 << (*expected->listSizes)[w] << "." << endl;
+            return false;
+        }
+        uint32_t n32 = (uint32_t)n;
+        if (!expected) postingsOut.write((const char*)&w, sizeof(w));
+        postingsOut.write((const char*)&n32, sizeof(n32));
+        for (size_t b = 0; b < blocks.size(); ++b) readers[blocks[b]].pass((uint64_t)counts[b] * 2, &postingsOut, copyBuffer);
+
+        for (size_t b = 0; b < blocks.size(); ++b) {
+            if (!readers[blocks[b]].readCount(counts[b])) {
+                cerr << "Error: " << files[blocks[b]] << " is truncated or unreadable." << endl;
+                return false;
+            }
+            m += counts[b];
+        }
+        uint32_t m32 = positionsOut ? (uint32_t)m : 0;
+        if (expected && positionsOut && m != (*expected->positionCounts)[w]) {
+            cerr << "Error: runs hold " << m << " positions for word " << w << ", expected "
+                 << (*expected->positionCounts)[w] << "." << endl;
+            return false;
+        }
+        ostream* positionsTo = expected ? positionsOut : &postingsOut;
+        if (positionsTo) positionsTo->write((const char*)&m32, sizeof(m32));
+        for (size_t b = 0; b < blocks.size(); ++b) readers[blocks[b]].pass(counts[b], positionsOut ? positionsTo : nullptr, copyBuffer);
+
+        for (size_t r : blocks) {
+            if (readers[r].advance()) heads.push({ readers[r].wordID, r });
+            if (readers[r].failed) {
+                cerr << "Error: " << files[r] << " is truncated or unreadable." << endl;
+                return false;
+            }
+        }
+        if (!postingsOut || (positionsTo && !*positionsTo)) {
+            cerr << "Error: writing the merged index failed." << endl;
+            return false;
+        }
+        w++;
+    }
+    return true;
+}
+
+bool invertExternal(ForwardReader& reader, uint32_t totalWords, size_t budgetBytes, const string& runPrefix,
+                    ofstream& outFile, ofstream& outPos) {
+    // Fixed cost: list sizes, position counts, the run's counting-sort offsets
+    // and the write buffer
+    size_t fixedBytes = (size_t)totalWords * 3 * sizeof(uint32_t) + COPY_BUFFER_BYTES;
+    size_t runBudget = budgetBytes > fixedBytes ? budgetBytes - fixedBytes : 0;
+    runBudget = max(runBudget, (size_t)1 << 20);
+    cout << "External inversion: " << runBudget / (1024 * 1024) << " MB for postings per run." << endl;
+
+    vector<uint32_t> listSizes(totalWords, 0);
+    vector<uint32_t> positionCounts(totalWords, 0);
+    RunWriter runs(totalWords, runBudget, reader.hasPositions());
+    bool positionsKept = reader.hasPositions(); // Whether the current run records them
+    int docsProcessed = 0;
+    vector<string> temporary; // Every run file written, for cleanup
+
+    auto fail = [&]() {
+        for (const string& path : runs.files) remove(path.c_str());
+        for (const string& path : temporary) remove(path.c_str());
+        return false;
+    };
+    auto flushRun = [&]() {
+        string path = runPrefix + to_string(runs.files.size());
+        if (!runs.flush(path, positionsKept)) {
+            cerr << "Error: could not write " << path << endl;
+            return false;
+        }
+        cout << "Flushed run " << runs.files.size() << " (" << docsProcessed << " docs)...\r" << flush;
+        return true;
+    };
+
+    cout << "Reading Forward Index..." << endl;
+    while (reader.next()) {
+        positionsKept = positionsKept && reader.hasPositions();
+        size_t posUsed = 0;
+        for (const auto& [wordID, freq] : reader.words) {
+            if (wordID < totalWords) {
+                // A doc may straddle two runs: its words' postings still land
+                // in forward-index order for each word
+                if (!runs.fits(freq, positionsKept) && !flushRun()) return fail();
+                listSizes[wordID]++;
+                positionCounts[wordID] += freq;
+                runs.add(wordID, reader.docID, freq, positionsKept ? reader.positions.data() + posUsed : nullptr);
+            }
+            posUsed += freq;
+        }
+        docsProcessed++;
+    }
+    if (!runs.empty() && !flushRun()) return fail();
+
+    // Too many runs to open at once: merge consecutive groups into longer
+    // runs first (order kept, so ties still go to the earlier docs)
+    vector<string> level = runs.files;
+    for (int pass = 1; level.size() > MAX_MERGE_FANIN; ++pass) {
+        cout << "\nMerge pass " << pass << ": " << level.size() << " runs..." << flush;
+        vector<string> next;
+        for (size_t g = 0; g < level.size(); g += MAX_MERGE_FANIN) {
+            vector<string> group(level.begin() + g, level.begin() + min(g + MAX_MERGE_FANIN, level.size()));
+            string path = runPrefix + "p" + to_string(pass) + "_" + to_string(next.size());
+            temporary.push_back(path);
+            ofstream out(path, ios::binary);
+            bool ok = out && mergeRuns(group, totalWords, out, positionsKept ? &out : nullptr, nullptr);
+            out.close();
+            if (!ok || !out) {
+                cerr << "Error: could not write " << path << endl;
+                return fail();
+            }
+            for (const string& done : group) remove(done.c_str());
+            next.push_back(path);
+        }
+        level.swap(next);
+    }
+
+    // K-way merge: all runs' blocks for word 0, then word 1, ... Ties go to
+    // the earlier run, which holds the earlier docs.
+    cout << "\nMerging " << level.size() << " runs..." << endl;
+    WordCounts expected = { &listSizes, reader.hasPositions() ? &positionCounts : nullptr };
+    bool merged = mergeRuns(level, totalWords, outFile, reader.hasPositions() ? &outPos : nullptr, &expected);
+    fail(); // Done with the run files either way
+    return merged;
+}
+
+int main(int argc, char* argv[]) {
+    // --mem-budget MB: invert in sorted runs on disk instead of all in RAM
+    size_t memBudgetMB = 0;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--mem-budget" && i + 1 < argc) memBudgetMB = (size_t)max(atoll(argv[++i]), 1LL);
+    }
+
+    // --- PATHS ---
+    const string FORWARD_FILE = "C:\\Users\\Hank47\\Sem3\\Rummager\\forward_index.bin";
+    const string LEXICON_FILE = "C:\\Users\\Hank47\\Sem3\\Rummager\\lexicon.bin";
+    const string OUTPUT_FILE  = "C:\\Users\\Hank47\\Sem3\\Rummager\\inverted_index.bin";
+    // Optional positional side files (forward_indexer --positions)
+    const string FORWARD_POS_FILE  = "C:\\Users\\Hank47\\Sem3\\Rummager\\forward_positions.bin";
+    const string INVERTED_POS_FILE = "C:\\Users\\Hank47\\Sem3\\Rummager\\inverted_positions.bin";
+    const string RUN_PREFIX = OUTPUT_FILE + ".run"; // --mem-budget temp files: .run0, .run1, ...
+    
+    // 1. Get Lexicon Size
+    LexiconView lexicon;
+    if (!lexicon.open(LEXICON_FILE)) { cerr << "Error: " << LEXICON_FILE << " missing." << endl; return 1; }
+    
+    uint32_t totalWords = lexicon.size();
+    lexicon.close();
+
+    cout << "Initializing Indexer for " << totalWords << " words..." << endl;
+
+    ForwardReader reader;
+    if (!reader.open(FORWARD_FILE, FORWARD_POS_FILE)) { cerr << "Error: " << FORWARD_FILE << " missing." << endl; return 1; }
+    if (reader.hasPositions()) cout << "Positions found: building inverted_positions.bin too." << endl;
+
+    // Header of both files: the word count, then one list per word
+    ofstream outFile(OUTPUT_FILE, ios::binary);
+    outFile.write((char*)&totalWords, sizeof(totalWords));
+    ofstream outPos;
+    if (reader.hasPositions()) {
+        outPos.open(INVERTED_POS_FILE, ios::binary);
+        outPos.write((char*)&totalWords, sizeof(totalWords));
+    }
+
+    bool ok = true;
+    if (memBudgetMB > 0) {
+        ok = invertExternal(reader, totalWords, memBudgetMB << 20, RUN_PREFIX, outFile, outPos);
+    } else {
+        invertInMemory(reader, totalWords, outFile, outPos);
+    }
     outFile.close();
+    if (outPos.is_open()) outPos.close();
+    if (ok && (!outFile || (reader.hasPositions() && !outPos))) {
+        cerr << "Error: writing " << OUTPUT_FILE << " failed." << endl;
+        ok = false;
+    }
+    if (!ok) {
+        // A half-written index must not look like a finished one
+        remove(OUTPUT_FILE.c_str());
+        remove(INVERTED_POS_FILE.c_str());
+        return 1;
+    }
+    if (!reader.hasPositions()) remove(INVERTED_POS_FILE.c_str()); // None, or dropped along the way
 
     cout << "Success! Inverted Index created." << endl;
     return 0;
@@ -91,11 +542,23 @@ int main() {
        - We create an array of lists: `vector<vector<Posting>> index(TotalWords)`.
        - We read the Forward Index stream (DocID, List of Words).
        - For each WordID in the doc, we append `{DocID, Freq}` to `index[WordID]`.
+       - If forward_positions.bin exists, each posting's positions are appended to a
+         parallel list the same way and written to inverted_positions.bin.
     
-    3. SCALABILITY NOTE
-       - If the index were too large for RAM (e.g., Google scale), we would use:
-         "External Sort-Based Inversion" (BSBI or SPIMI).
-         - Write (WordID, DocID) pairs to disk.
-         - Sort them by WordID using Merge Sort.
-         - Compress into Posting Lists.
+    3. SCALABILITY ("--mem-budget MB")
+       - Millions of small vectors, each over-allocated by push_back, take far more
+         RAM than the postings themselves; past some corpus size this runs out.
+       - With a budget, inversion is external (SPIMI-style):
+         - Postings go into one flat buffer, allocated once from the budget; when it
+           is full (even mid-doc) it is flushed, so RAM stays within the budget.
+         - The buffer is grouped by WordID (counting sort, so each word keeps the
+           forward index's doc order) and written as a sorted run file.
+         - A k-way merge (min-heap on WordID) then writes every word's blocks from
+           all runs, earliest run first. More than MAX_MERGE_FANIN runs are first
+           merged in groups, so only that many files are ever open.
+         - List sizes are also counted while reading; the final merge checks every
+           list against them, so a lost or truncated run fails the build instead
+           of leaving a silently wrong index.
+       - The result is byte-identical to the in-memory path; only the run files
+         (inverted_index.bin.run0, .run1, ...) and one block per run are on the side.
 */
\ No newline at end of file
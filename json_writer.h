@@ -0,0 +1,113 @@
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <string>
+#include <string_view>
+#include <ostream>
+#include <charconv>
+#include <type_traits>
+#include <cstdio>
+#include <cstdint>
+
+using namespace std;
+
+// ---------------------------------------------------------
+// JSON WRITER (searchengine --json / --serve / --batch)
+// ---------------------------------------------------------
+// Builds one response in a buffer that is reused from query to query, so a
+// warm writer allocates nothing, and hands it to the stream in one write.
+// Only what the engine's responses need: raw text, escaped strings, numbers.
+
+// True for the bytes a JSON string can't hold as they are
+inline bool jsonNeedsEscape(unsigned char c) { return c < 0x20 || c == '"' || c == '\\'; }
+
+// Appends 's' escaped (no quotes). Runs that need no escaping, i.e. nearly
+// all of a title or author list, are copied with one append each.
+inline void appendJsonEscaped(string& out, string_view s) {
+    static const char hex[] = "0123456789abcdef";
+    size_t runStart = 0;
+    for (size_t i = 0; i < s.size(); ++i) {
+        unsigned char c = (unsigned char)s[i];
+        if (!jsonNeedsEscape(c)) continue;
+        out.append(s.data() + runStart, i - runStart);
+        runStart = i + 1;
+        switch (c) {
+            case '"':  out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\b': out += "\\b"; break;
+            case '\f': out += "\\f"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default: {
+                char u[6] = { '\\', 'u', '0', '0', hex[c >> 4], hex[c & 15] };
+                out.append(u, sizeof(u));
+            }
+        }
+    }
+    out.append(s.data() + runStart, s.size() - runStart);
+}
+
+class JsonWriter {
+private:
+    string buffer; // Capacity survives clear(): grows to the largest response, then stays
+
+public:
+    void clear() { buffer.clear(); }
+    const string& str() const { return buffer; }
+
+    JsonWriter& raw(string_view s) {
+        buffer.append(s.data(), s.size());
+        return *this;
+    }
+
+    // "s", escaped
+    JsonWriter& quoted(string_view s) {
+        buffer += '"';
+        appendJsonEscaped(buffer, s);
+        buffer += '"';
+        return *this;
+    }
+
+    // Integers exactly; doubles like ostream's default (6 significant digits)
+    template<typename T>
+    JsonWriter& number(T value) {
+        char digits[32];
+        if constexpr (is_integral_v<T>) {
+            to_chars_result done = to_chars(digits, digits + sizeof(digits), value);
+            buffer.append(digits, done.ptr - digits);
+        } else {
+            int n = snprintf(digits, sizeof(digits), "%g", (double)value);
+            if (n > 0) buffer.append(digits, (size_t)n);
+        }
+        return *this;
+    }
+
+    JsonWriter& boolean(bool value) { return raw(value ? "true" : "false"); }
+
+    // The whole response in one write, then flushed (as endl did)
+    void writeTo(ostream& out) const {
+        out.write(buffer.data(), (streamsize)buffer.size());
+        out.flush();
+    }
+};
+
+#endif
+
+/*
+    ========================================================================================
+    EDUCATIONAL SUMMARY: JSON WRITER
+    ========================================================================================
+
+    1. WHY?
+       - Responses were built with dozens of "out <<" calls per result, and every
+         field went through a fresh std::string grown one character at a time.
+         For 120 results with long author lists that was a visible share of the
+         request.
+       - Now the response is assembled in one reused buffer and written once.
+
+    2. ESCAPING
+       - Text is scanned for the few bytes JSON can't carry raw ('"', '\', control
+         characters) and copied a run at a time between them; control characters
+         without a short form become \u00XX instead of slipping through raw.
+*/
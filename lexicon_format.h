@@ -0,0 +1,346 @@
+#ifndef LEXICON_FORMAT_H
+#define LEXICON_FORMAT_H
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <filesystem>
+#include "mapped_file.h"
+
+using namespace std;
+
+// ---------------------------------------------------------
+// LEXICON v2 (lexicon.bin): mmappable, perfect hash
+// ---------------------------------------------------------
+// v1 (legacy): [numWords: uint32] then [len: uint32][chars] per word, in
+//              wordID order. Every reader rebuilt an unordered_map from it.
+//
+// v2:          [LexiconHeader]
+//              [LexiconEntry x numTerms]       <- indexed by wordID
+//              [pilot: uint32 x numBuckets]    <- the perfect hash
+//              [wordID: uint32 x numSlots]     <- hash slot -> wordID (NO_WORD if free)
+//              [String pool: raw chars]
+//   (every section starts 8-byte aligned)
+//
+// Lookup (CHD / PTHash style "hash and displace"):
+//   h = hash(word); bucket = h -> [0, numBuckets); slot = mix(h, pilot[bucket]) -> [0, numSlots)
+//   wordID = slots[slot], then one memcmp against the pool rejects words
+//   that aren't in the lexicon. No probing, no parsing at load: the file is
+//   mapped and used as is. numSlots is ~5% above numTerms: a completely
+//   full table makes the last buckets search for ages, a few free slots
+//   (4 bytes each) keep the build at a second or two for millions of words.
+
+const uint32_t LEXICON_MAGIC = 0x58454C52; // "RLEX"
+const uint32_t LEXICON_VERSION = 2;
+const uint64_t NO_LIST_OFFSET = UINT64_MAX; // Barrels not built (yet) for this lexicon
+const uint32_t NO_WORD = UINT32_MAX;
+
+const uint32_t LEXICON_BUCKET_LOAD = 3;          // Average keys per bucket: ~1.3 bytes of pilots per term
+const uint32_t LEXICON_MAX_PILOT = 1u << 22;     // Give up on a seed after this many tries per bucket
+const uint32_t LEXICON_MAX_SEEDS = 16;
+
+struct LexiconHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t numTerms;
+    uint32_t numBuckets;
+    uint32_t numSlots;
+    uint32_t reserved;
+    uint64_t seed;       // Hash salt the pilots were found for
+    uint64_t poolBytes;
+};
+
+struct LexiconEntry {
+    uint64_t listOffset; // Posting list offset in barrel (wordID / WORDS_PER_BARREL), written by create_barrels
+    uint32_t nameOffset; // Into the string pool
+    uint32_t nameLength;
+    uint32_t df;         // Documents containing the word
+    uint32_t reserved;
+};
+
+inline size_t align8(size_t n) { return (n + 7) & ~(size_t)7; }
+
+inline uint64_t mix64(uint64_t x) { // splitmix64 finalizer
+    x ^= x >> 30; x *= 0xBF58476D1CE4E5B9ULL;
+    x ^= x >> 27; x *= 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+inline uint64_t lexiconHash(const char* s, size_t len, uint64_t seed) {
+    uint64_t h = 0xCBF29CE484222325ULL ^ seed; // FNV-1a, then mixed
+    for (size_t i = 0; i < len; ++i) {
+        h ^= (unsigned char)s[i];
+        h *= 0x100000001B3ULL;
+    }
+    return mix64(h + len);
+}
+
+// [0, n) without a division
+inline uint32_t fastRange(uint32_t x, uint32_t n) { return (uint32_t)(((uint64_t)x * n) >> 32); }
+
+inline uint32_t lexiconBucket(uint64_t h, uint32_t numBuckets) { return fastRange((uint32_t)(h >> 32), numBuckets); }
+inline uint32_t lexiconSlot(uint64_t h, uint32_t pilot, uint32_t numSlots) {
+    return fastRange((uint32_t)mix64(h ^ ((uint64_t)(pilot + 1) * 0x9E3779B97F4A7C15ULL)), numSlots);
+}
+
+// --- BUILDING (build_lexicon, add_document, create_barrels) ---
+
+// 'words' in wordID order (unique). 'df' / 'listOffsets' may be empty
+// (= 0 / NO_LIST_OFFSET). Returns the whole file image, or an empty
+// vector if no seed gave a perfect hash (only with duplicate words).
+inline vector<uint8_t> buildLexicon(const vector<string>& words, const vector<uint32_t>& df = {},
+                                    const vector<uint64_t>& listOffsets = {}) {
+    uint32_t n = (uint32_t)words.size();
+    uint32_t numBuckets = n ? (n + LEXICON_BUCKET_LOAD - 1) / LEXICON_BUCKET_LOAD : 0;
+    uint32_t numSlots = n ? n + n / 20 + 1 : 0;
+    vector<uint32_t> pilots(numBuckets, 0), slots(numSlots, NO_WORD);
+    vector<uint64_t> hashes(n);
+
+    uint64_t seed = 0;
+    bool placed = (n == 0);
+    for (uint32_t attempt = 0; attempt < LEXICON_MAX_SEEDS && !placed; ++attempt) {
+        seed = mix64(0x5EED + attempt);
+        for (uint32_t i = 0; i < n; ++i) hashes[i] = lexiconHash(words[i].data(), words[i].size(), seed);
+
+        // Keys grouped by bucket (counting sort)
+        vector<uint32_t> bucketStart(numBuckets + 1, 0), keys(n);
+        for (uint32_t i = 0; i < n; ++i) bucketStart[lexiconBucket(hashes[i], numBuckets) + 1]++;
+        for (uint32_t b = 0; b < numBuckets; ++b) bucketStart[b + 1] += bucketStart[b];
+        vector<uint32_t> next(bucketStart.begin(), bucketStart.end() - 1);
+        for (uint32_t i = 0; i < n; ++i) keys[next[lexiconBucket(hashes[i], numBuckets)]++] = i;
+
+        // Biggest buckets first, while the table is still empty
+        uint32_t maxSize = 0;
+        for (uint32_t b = 0; b < numBuckets; ++b) maxSize = max(maxSize, bucketStart[b + 1] - bucketStart[b]);
+        vector<uint32_t> sizeStart(maxSize + 2, 0), order(numBuckets);
+        for (uint32_t b = 0; b < numBuckets; ++b) sizeStart[maxSize - (bucketStart[b + 1] - bucketStart[b]) + 1]++;
+        for (uint32_t s = 0; s <= maxSize; ++s) sizeStart[s + 1] += sizeStart[s];
+        for (uint32_t b = 0; b < numBuckets; ++b) order[sizeStart[maxSize - (bucketStart[b + 1] - bucketStart[b])]++] = b;
+
+        vector<uint8_t> taken(numSlots, 0);
+        fill(slots.begin(), slots.end(), NO_WORD);
+        vector<uint32_t> trial;
+        placed = true;
+        for (uint32_t b : order) {
+            uint32_t first = bucketStart[b], last = bucketStart[b + 1];
+            if (first == last) break; // Sizes descend: only empty buckets remain
+            bool ok = false;
+            for (uint32_t pilot = 0; pilot < LEXICON_MAX_PILOT && !ok; ++pilot) {
+                trial.clear();
+                ok = true;
+                for (uint32_t k = first; k < last && ok; ++k) {
+                    uint32_t slot = lexiconSlot(hashes[keys[k]], pilot, numSlots);
+                    if (taken[slot] || find(trial.begin(), trial.end(), slot) != trial.end()) ok = false;
+                    else trial.push_back(slot);
+                }
+                if (ok) {
+                    pilots[b] = pilot;
+                    for (uint32_t k = first; k < last; ++k) {
+                        taken[trial[k - first]] = 1;
+                        slots[trial[k - first]] = keys[k];
+                    }
+                }
+            }
+            if (!ok) { placed = false; break; }
+        }
+    }
+    if (!placed) return {};
+
+    LexiconHeader header = { LEXICON_MAGIC, LEXICON_VERSION, n, numBuckets, numSlots, 0, seed, 0 };
+    vector<LexiconEntry> entries(n);
+    uint64_t pool = 0;
+    for (uint32_t i = 0; i < n; ++i) {
+        entries[i].listOffset = (i < listOffsets.size()) ? listOffsets[i] : NO_LIST_OFFSET;
+        entries[i].nameOffset = (uint32_t)pool;
+        entries[i].nameLength = (uint32_t)words[i].size();
+        entries[i].df = (i < df.size()) ? df[i] : 0;
+        entries[i].reserved = 0;
+        pool += words[i].size();
+    }
+    header.poolBytes = pool;
+
+    size_t entriesAt = align8(sizeof(header));
+    size_t pilotsAt = align8(entriesAt + (size_t)n * sizeof(LexiconEntry));
+    size_t slotsAt = align8(pilotsAt + (size_t)numBuckets * sizeof(uint32_t));
+    size_t poolAt = align8(slotsAt + (size_t)numSlots * sizeof(uint32_t));
+    vector<uint8_t> out(poolAt + pool, 0);
+    memcpy(out.data(), &header, sizeof(header));
+    if (n) {
+        memcpy(out.data() + entriesAt, entries.data(), (size_t)n * sizeof(LexiconEntry));
+        memcpy(out.data() + pilotsAt, pilots.data(), (size_t)numBuckets * sizeof(uint32_t));
+        memcpy(out.data() + slotsAt, slots.data(), (size_t)numSlots * sizeof(uint32_t));
+    }
+    for (uint32_t i = 0; i < n; ++i) memcpy(out.data() + poolAt + entries[i].nameOffset, words[i].data(), words[i].size());
+    return out;
+}
+
+// Writes next to 'path' and renames over it, so a reader never maps half a file
+inline bool writeLexicon(const string& path, const vector<string>& words, const vector<uint32_t>& df = {},
+                         const vector<uint64_t>& listOffsets = {}) {
+    vector<uint8_t> image = buildLexicon(words, df, listOffsets);
+    if (image.empty()) return false;
+
+    string tmp = path + ".tmp";
+    {
+        ofstream out(tmp, ios::binary);
+        if (!out) return false;
+        out.write((const char*)image.data(), image.size());
+        if (!out) return false;
+    }
+    error_code ec;
+    std::filesystem::rename(tmp, path, ec);
+    return !ec;
+}
+
+// --- READING (every tool) ---
+
+class LexiconView {
+private:
+    MappedFile file;
+    vector<uint8_t> image; // v1 files are converted in memory
+    const uint8_t* base = nullptr;
+    uint32_t numTerms = 0;
+    uint32_t numBuckets = 0;
+    uint32_t numSlots = 0;
+    uint64_t seed = 0;
+    const LexiconEntry* entries = nullptr;
+    const uint32_t* pilots = nullptr;
+    const uint32_t* slots = nullptr;
+    const char* pool = nullptr;
+    uint64_t poolBytes = 0;
+    bool legacy = false;
+
+    // Sets the section pointers; false if the image is inconsistent
+    bool attach(const uint8_t* data, size_t size) {
+        if (size < sizeof(LexiconHeader)) return false;
+        LexiconHeader header;
+        memcpy(&header, data, sizeof(header));
+        if (header.magic != LEXICON_MAGIC || header.version != LEXICON_VERSION) return false;
+
+        size_t entriesAt = align8(sizeof(header));
+        size_t pilotsAt = align8(entriesAt + (size_t)header.numTerms * sizeof(LexiconEntry));
+        size_t slotsAt = align8(pilotsAt + (size_t)header.numBuckets * sizeof(uint32_t));
+        size_t poolAt = align8(slotsAt + (size_t)header.numSlots * sizeof(uint32_t));
+        if (poolAt > size || header.poolBytes > size - poolAt) return false;
+        if (header.numTerms > 0 && (header.numBuckets == 0 || header.numSlots < header.numTerms)) return false;
+
+        base = data;
+        numTerms = header.numTerms;
+        numBuckets = header.numBuckets;
+        numSlots = header.numSlots;
+        seed = header.seed;
+        entries = (const LexiconEntry*)(data + entriesAt);
+        pilots = (const uint32_t*)(data + pilotsAt);
+        slots = (const uint32_t*)(data + slotsAt);
+        pool = (const char*)(data + poolAt);
+        poolBytes = header.poolBytes;
+        return true;
+    }
+
+public:
+    LexiconView() = default;
+    LexiconView(const LexiconView&) = delete;
+    LexiconView& operator=(const LexiconView&) = delete;
+
+    // v2: mapped, nothing parsed. v1: read once and converted in memory.
+    bool open(const string& path) {
+        close();
+        if (file.open(path) && attach(file.data(), file.size())) return true;
+        file.close();
+
+        vector<string> words;
+        if (!readLegacyLexicon(path, words)) return false;
+        image = buildLexicon(words);
+        legacy = true;
+        return attach(image.data(), image.size());
+    }
+
+    void close() {
+        file.close();
+        image.clear();
+        base = nullptr;
+        numTerms = numBuckets = numSlots = 0;
+        entries = nullptr; pilots = nullptr; slots = nullptr; pool = nullptr;
+        poolBytes = 0;
+        legacy = false;
+    }
+
+    uint32_t size() const { return numTerms; }
+    bool empty() const { return numTerms == 0; }
+    bool isLegacy() const { return legacy; } // Loaded from a v1 file
+
+    // wordID, or -1 if the word isn't in the lexicon
+    int32_t find(const char* s, size_t len) const {
+        if (numTerms == 0) return -1;
+        uint64_t h = lexiconHash(s, len, seed);
+        uint32_t id = slots[lexiconSlot(h, pilots[lexiconBucket(h, numBuckets)], numSlots)];
+        if (id >= numTerms) return -1;
+        const LexiconEntry& e = entries[id];
+        if (e.nameLength != len || (uint64_t)e.nameOffset + len > poolBytes) return -1;
+        return memcmp(pool + e.nameOffset, s, len) == 0 ? (int32_t)id : -1;
+    }
+    int32_t find(const string& word) const { return find(word.data(), word.size()); }
+
+    string word(uint32_t id) const {
+        const LexiconEntry& e = entries[id];
+        if ((uint64_t)e.nameOffset + e.nameLength > poolBytes) return string();
+        return string(pool + e.nameOffset, e.nameLength);
+    }
+    uint32_t df(uint32_t id) const { return entries[id].df; }
+    uint64_t listOffset(uint32_t id) const { return entries[id].listOffset; }
+
+    size_t mappedBytes() const { return file.isOpen() ? file.size() : image.size(); }
+
+    // Words in wordID order, e.g. to write an updated lexicon
+    vector<string> words() const {
+        vector<string> out(numTerms);
+        for (uint32_t i = 0; i < numTerms; ++i) out[i] = word(i);
+        return out;
+    }
+
+    // Reads a v1 file. False if missing or not v1.
+    static bool readLegacyLexicon(const string& path, vector<string>& words) {
+        ifstream in(path, ios::binary);
+        if (!in) return false;
+        uint32_t total = 0;
+        if (!in.read((char*)&total, sizeof(total)) || total == LEXICON_MAGIC) return false;
+        words.clear();
+        words.reserve(total);
+        for (uint32_t i = 0; i < total; ++i) {
+            uint32_t len;
+            if (!in.read((char*)&len, sizeof(len))) return false;
+            string word(len, ' ');
+            if (!in.read(&word[0], len)) return false;
+            words.push_back(move(word));
+        }
+        return true;
+    }
+};
+
+#endif
+
+/*
+    ========================================================================================
+    EDUCATIONAL SUMMARY: LEXICON v2
+    ========================================================================================
+
+    1. WHY?
+       - Rebuilding an unordered_map<string,int> from millions of words took seconds
+         at every start and roughly a heap node + a string per word.
+       - v2 is a flat file: map it and answer lookups straight from the page cache.
+
+    2. PERFECT HASH
+       - Words are hashed into buckets (~3 per bucket). Each bucket stores one
+         "pilot": the first value that sends all its words to free slots.
+       - Big buckets go first, while the table is still empty. The table has ~5%
+         spare slots, so the last small buckets still find room quickly.
+       - The hash can't say "not found", so the word is compared once with the
+         pool to reject unknown words.
+
+    3. INLINE STATISTICS
+       - df and the posting list's barrel offset sit next to each word, so tools
+         can look at a term's size without opening a barrel.
+*/
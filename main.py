@@ -1,4 +1,5 @@
 import os
+import socket
 import subprocess
 import shutil
 import time
@@ -14,6 +15,9 @@ CORS(app)
 RAILWAY_ENVIRONMENT = os.getenv("RAILWAY_ENVIRONMENT", "false").lower() == "true"
 SEARCH_ENGINE_PATH = "./searchengine.exe" if os.name == 'nt' else "./searchengine"
 DOC_LIMIT = "10000" if RAILWAY_ENVIRONMENT else "0"
+# Set to run the engine as a multi-threaded server (searchengine --serve)
+# instead of one stdin pipe that serializes every request
+ENGINE_PORT = os.getenv("ENGINE_PORT", "")
 
 engine_process = None
 
@@ -23,6 +27,8 @@ def start_engine():
     args = [SEARCH_ENGINE_PATH, "--json"]
     if DOC_LIMIT != "0":
         args.extend(["--limit", DOC_LIMIT])
+    if ENGINE_PORT:
+        args.extend(["--serve", ENGINE_PORT])
     
     print(f"Starting Search Engine: {' '.join(args)}")
     
@@ -33,9 +39,9 @@ def start_engine():
 
     engine_process = subprocess.Popen(
         args,
-        stdin=subprocess.PIPE,
-        stdout=subprocess.PIPE,
-        stderr=subprocess.PIPE,
+        stdin=subprocess.DEVNULL if ENGINE_PORT else subprocess.PIPE,
+        stdout=subprocess.DEVNULL if ENGINE_PORT else subprocess.PIPE,
+        stderr=subprocess.DEVNULL if ENGINE_PORT else subprocess.PIPE,
         text=True,
         encoding='utf-8', 
         errors='ignore'
@@ -44,17 +50,40 @@ def start_engine():
 def stop_engine():
     global engine_process
     if engine_process:
-        engine_process.stdin.close()
+        if engine_process.stdin:
+            engine_process.stdin.close()
         engine_process.terminate()
         engine_process.wait()
 
 start_engine()
 
 # --- API HELPERS ---
+def send_over_socket(command: str) -> str:
+    # One short-lived connection per request: the engine's workers answer them in parallel
+    for attempt in range(20):
+        try:
+            with socket.create_connection(("127.0.0.1", int(ENGINE_PORT)), timeout=30) as sock:
+                sock.sendall((command + "\n").encode("utf-8"))
+                output = b""
+                while not output.endswith(b"\n"):
+                    chunk = sock.recv(65536)
+                    if not chunk:
+                        break
+                    output += chunk
+                return output.decode("utf-8", errors="ignore")
+        except ConnectionRefusedError:
+            time.sleep(0.5) # Engine still loading
+        except Exception as e:
+            return f'{{"error": "{str(e)}"}}'
+    return '{"error": "engine not reachable"}'
+
 def send_to_engine(command: str) -> str:
     if not engine_process or engine_process.poll() is not None:
         start_engine() # Restart if dead
         time.sleep(1)
+
+    if ENGINE_PORT:
+        return send_over_socket(command)
     
     try:
         engine_process.stdin.write(command + "\n")
@@ -98,8 +127,15 @@ def search():
     query = request.args.get('q', '')
     if not query: return jsonify([])
     
+    # Paging is done by the engine (/offset:N /limit:N)
+    paging = ""
+    offset = request.args.get('offset', '')
+    limit = request.args.get('limit', '')
+    if offset.isdigit(): paging += f" /offset:{offset}"
+    if limit.isdigit(): paging += f" /limit:{limit}"
+
     # 1. Primary Search
-    results = run_search(query)
+    results = run_search(query + paging)
     
     # 2. Semantic Expansion
     # Search for synonyms if we have the brain loaded
@@ -160,12 +196,14 @@ def search():
             
              seen_ids.add(r['id'])
             
-    # Restore time_ms from primary search if available
+    # Restore time_ms / paging info from primary search if available
     total_time = 0
+    has_more = False
     if isinstance(results, dict):
         total_time = results.get('time_ms', 0)
+        has_more = results.get('has_more', False)
 
-    return jsonify({"results": final_output, "time_ms": total_time})
+    return jsonify({"results": final_output, "time_ms": total_time, "has_more": has_more})
 
 def run_search(q):
     # Use persistent process to avoid loading 3.4GB index every time
@@ -0,0 +1,136 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+
+#ifdef _WIN32
+    #ifndef NOMINMAX
+    #define NOMINMAX
+    #endif
+    #include <windows.h>
+#else
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+using namespace std;
+
+// ---------------------------------------------------------
+// READ-ONLY MEMORY MAPPED FILE
+// ---------------------------------------------------------
+// Maps a whole file once and exposes it as a byte range.
+// The OS page cache backs the mapping, so "reading" a posting
+// list is just pointer arithmetic after the first touch.
+class MappedFile {
+private:
+    const uint8_t* ptr = nullptr;
+    size_t length = 0;
+#ifdef _WIN32
+    HANDLE fileHandle = INVALID_HANDLE_VALUE;
+    HANDLE mapHandle = NULL;
+#endif
+
+public:
+    MappedFile() = default;
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    MappedFile(MappedFile&& other) noexcept { swapWith(other); }
+    MappedFile& operator=(MappedFile&& other) noexcept {
+        if (this != &other) {
+            close();
+            swapWith(other);
+        }
+        return *this;
+    }
+
+    bool open(const string& path) {
+        close();
+#ifdef _WIN32
+        fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE,
+                                 NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (fileHandle == INVALID_HANDLE_VALUE) return false;
+
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0) { close(); return false; }
+        length = (size_t)fileSize.QuadPart;
+
+        mapHandle = CreateFileMappingA(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mapHandle == NULL) { close(); return false; }
+
+        ptr = (const uint8_t*)MapViewOfFile(mapHandle, FILE_MAP_READ, 0, 0, 0);
+        if (ptr == nullptr) { close(); return false; }
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size == 0) { ::close(fd); return false; }
+        length = (size_t)st.st_size;
+
+        void* p = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd); // The mapping keeps its own reference to the file
+        if (p == MAP_FAILED) { length = 0; return false; }
+        ptr = (const uint8_t*)p;
+#endif
+        return true;
+    }
+
+    void close() {
+#ifdef _WIN32
+        if (ptr) UnmapViewOfFile(ptr);
+        if (mapHandle != NULL) CloseHandle(mapHandle);
+        if (fileHandle != INVALID_HANDLE_VALUE) CloseHandle(fileHandle);
+        mapHandle = NULL;
+        fileHandle = INVALID_HANDLE_VALUE;
+#else
+        if (ptr) munmap((void*)ptr, length);
+#endif
+        ptr = nullptr;
+        length = 0;
+    }
+
+    bool isOpen() const { return ptr != nullptr; }
+    const uint8_t* data() const { return ptr; }
+    size_t size() const { return length; }
+
+    // Bytes of this mapping currently held in physical memory.
+    // Windows has no cheap equivalent of mincore(), so we report 0 there.
+    size_t residentBytes() const {
+#ifdef _WIN32
+        return 0;
+#else
+        if (!ptr) return 0;
+        size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+        size_t pages = (length + pageSize - 1) / pageSize;
+        vector<unsigned char> vec(pages);
+        if (mincore((void*)ptr, length, vec.data()) != 0) return 0;
+
+        size_t resident = 0;
+        for (unsigned char v : vec) {
+            if (v & 1) resident += pageSize;
+        }
+        return resident < length ? resident : length;
+#endif
+    }
+
+private:
+    void swapWith(MappedFile& other) {
+        std::swap(ptr, other.ptr);
+        std::swap(length, other.length);
+#ifdef _WIN32
+        std::swap(fileHandle, other.fileHandle);
+        std::swap(mapHandle, other.mapHandle);
+#endif
+    }
+};
+
+#endif
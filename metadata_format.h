@@ -0,0 +1,268 @@
+#ifndef METADATA_FORMAT_H
+#define METADATA_FORMAT_H
+
+#include <vector>
+#include <string>
+#include <string_view>
+#include <fstream>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include "mapped_file.h"
+
+using namespace std;
+
+// ---------------------------------------------------------
+// METADATA STORE (doc_metadata.bin, next to doc_metadata.txt)
+// ---------------------------------------------------------
+// doc_metadata.txt ("ID|Title|Authors|Category|Date" per line, line d = doc d)
+// stored column by column:
+//
+//   [MetadataHeader]
+//   per field (8-byte aligned):
+//     [offset: uint32 x (numDocs + 1)]   <- field of doc d = pool[offset[d], offset[d+1])
+//     [pool: raw chars, back to back]
+//
+// The engine maps the file and copies out the fields of the docs it prints,
+// nothing else: no parse at load, no strings per doc in RAM. The filterable
+// fields also have integer forms of their own: categories.bin
+// (category_format.h) and doc_dates.bin (date_format.h).
+
+const uint32_t METADATA_MAGIC = 0x54454D52; // "RMET"
+const uint32_t METADATA_VERSION = 1;
+
+enum MetadataField : uint32_t {
+    META_ID = 0,
+    META_TITLE,
+    META_AUTHORS,
+    META_CATEGORY,
+    META_DATE,
+    META_FIELDS
+};
+
+struct MetadataHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t numDocs;
+    uint32_t numFields;             // META_FIELDS
+    uint64_t sourceBytes;           // Size of the doc_metadata.txt it was built from (staleness check)
+    uint64_t columnAt[META_FIELDS]; // Offset array of each field, from the start of the file
+    uint64_t poolBytes[META_FIELDS];
+};
+
+inline size_t metadataAlign8(size_t n) { return (n + 7) & ~(size_t)7; }
+
+// Splits one doc_metadata.txt line the way getline(ss, field, '|') always
+// did: missing fields are empty, anything past the fifth '|' is ignored.
+inline void splitMetadataLine(const string& line, const char* fields[META_FIELDS], size_t lengths[META_FIELDS]) {
+    size_t pos = 0;
+    for (uint32_t f = 0; f < META_FIELDS; ++f) {
+        if (pos > line.size()) {
+            fields[f] = line.data() + line.size();
+            lengths[f] = 0;
+            continue;
+        }
+        size_t bar = line.find('|', pos);
+        size_t end = (bar == string::npos) ? line.size() : bar;
+        fields[f] = line.data() + pos;
+        lengths[f] = end - pos;
+        pos = (bar == string::npos) ? line.size() + 1 : bar + 1;
+    }
+}
+
+// --- BUILDING (create_barrels, add_document, or the engine if doc_metadata.bin is stale) ---
+
+class MetadataStoreBuilder {
+private:
+    string pools[META_FIELDS];
+    vector<uint32_t> offsets[META_FIELDS];
+    bool overflow = false; // A column outgrew 32-bit offsets
+
+public:
+    MetadataStoreBuilder() {
+        for (uint32_t f = 0; f < META_FIELDS; ++f) offsets[f].push_back(0);
+    }
+
+    // One doc_metadata.txt line = the next doc
+    void add(const string& line) {
+        const char* fields[META_FIELDS];
+        size_t lengths[META_FIELDS];
+        splitMetadataLine(line, fields, lengths);
+        for (uint32_t f = 0; f < META_FIELDS; ++f) {
+            pools[f].append(fields[f], lengths[f]);
+            if (pools[f].size() > UINT32_MAX) overflow = true;
+            offsets[f].push_back((uint32_t)pools[f].size());
+        }
+    }
+
+    uint32_t size() const { return (uint32_t)(offsets[0].size() - 1); }
+
+    // The whole file image; empty if a column passed 4 GB
+    vector<uint8_t> image(uint64_t sourceBytes = 0) const {
+        if (overflow) return {};
+        MetadataHeader header;
+        memset(&header, 0, sizeof(header));
+        header.magic = METADATA_MAGIC;
+        header.version = METADATA_VERSION;
+        header.numDocs = size();
+        header.numFields = META_FIELDS;
+        header.sourceBytes = sourceBytes;
+
+        size_t at = metadataAlign8(sizeof(header));
+        for (uint32_t f = 0; f < META_FIELDS; ++f) {
+            header.columnAt[f] = at;
+            header.poolBytes[f] = pools[f].size();
+            at = metadataAlign8(at + offsets[f].size() * sizeof(uint32_t) + pools[f].size());
+        }
+
+        vector<uint8_t> out(at, 0);
+        memcpy(out.data(), &header, sizeof(header));
+        for (uint32_t f = 0; f < META_FIELDS; ++f) {
+            uint8_t* p = out.data() + header.columnAt[f];
+            memcpy(p, offsets[f].data(), offsets[f].size() * sizeof(uint32_t));
+            if (!pools[f].empty()) memcpy(p + offsets[f].size() * sizeof(uint32_t), pools[f].data(), pools[f].size());
+        }
+        return out;
+    }
+};
+
+inline uint64_t metadataSourceBytes(const string& textPath) {
+    error_code ec;
+    uintmax_t bytes = std::filesystem::file_size(textPath, ec);
+    return ec ? 0 : (uint64_t)bytes;
+}
+
+// Reads doc_metadata.txt into a store image (first 'limit' docs if > 0).
+// Empty if the file is missing.
+inline vector<uint8_t> buildMetadataStore(const string& textPath, uint32_t limit = 0) {
+    ifstream in(textPath);
+    if (!in) return {};
+    MetadataStoreBuilder builder;
+    string line;
+    while (getline(in, line)) {
+        if (limit > 0 && builder.size() >= limit) break;
+        builder.add(line);
+    }
+    return builder.image(metadataSourceBytes(textPath));
+}
+
+// Writes next to 'path' and renames over it, so a reader never maps half a file
+inline bool writeMetadataStore(const string& path, const vector<uint8_t>& image) {
+    if (image.empty()) return false;
+    string tmp = path + ".tmp";
+    {
+        ofstream out(tmp, ios::binary);
+        if (!out) return false;
+        out.write((const char*)image.data(), image.size());
+        if (!out) return false;
+    }
+    error_code ec;
+    std::filesystem::rename(tmp, path, ec);
+    return !ec;
+}
+
+// --- READING (searchengine) ---
+
+class MetadataStore {
+private:
+    MappedFile file;
+    vector<uint8_t> image; // Built in memory when the file is missing or stale
+    uint32_t numDocs = 0;
+    uint64_t source = 0;
+    const uint32_t* offsets[META_FIELDS] = {};
+    const char* pools[META_FIELDS] = {};
+
+    // Sets the column pointers; false if the image is inconsistent
+    bool attach(const uint8_t* data, size_t size) {
+        if (size < sizeof(MetadataHeader)) return false;
+        MetadataHeader header;
+        memcpy(&header, data, sizeof(header));
+        if (header.magic != METADATA_MAGIC || header.version != METADATA_VERSION ||
+            header.numFields != META_FIELDS) return false;
+
+        size_t offsetBytes = ((size_t)header.numDocs + 1) * sizeof(uint32_t);
+        for (uint32_t f = 0; f < META_FIELDS; ++f) {
+            if (header.columnAt[f] % 4 != 0 || header.columnAt[f] > size ||
+                offsetBytes + header.poolBytes[f] > size - header.columnAt[f]) return false;
+            const uint32_t* column = (const uint32_t*)(data + header.columnAt[f]);
+            if (column[header.numDocs] != header.poolBytes[f]) return false; // Last offset = pool size
+        }
+
+        numDocs = header.numDocs;
+        source = header.sourceBytes;
+        for (uint32_t f = 0; f < META_FIELDS; ++f) {
+            offsets[f] = (const uint32_t*)(data + header.columnAt[f]);
+            pools[f] = (const char*)(data + header.columnAt[f] + offsetBytes);
+        }
+        return true;
+    }
+
+public:
+    MetadataStore() = default;
+    MetadataStore(const MetadataStore&) = delete;
+    MetadataStore& operator=(const MetadataStore&) = delete;
+
+    bool open(const string& path) {
+        close();
+        if (file.open(path) && attach(file.data(), file.size())) return true;
+        close();
+        return false;
+    }
+
+    // Takes over an image from buildMetadataStore
+    bool adopt(vector<uint8_t>&& built) {
+        close();
+        image = move(built);
+        if (attach(image.data(), image.size())) return true;
+        close();
+        return false;
+    }
+
+    void close() {
+        file.close();
+        image.clear();
+        numDocs = 0;
+        source = 0;
+        for (uint32_t f = 0; f < META_FIELDS; ++f) {
+            offsets[f] = nullptr;
+            pools[f] = nullptr;
+        }
+    }
+
+    uint32_t size() const { return numDocs; }
+    bool isMapped() const { return file.isOpen(); }
+    uint64_t sourceBytes() const { return source; }
+    size_t bytes() const { return file.isOpen() ? file.size() : image.size(); }
+
+    // One field in place, valid while the store is open ("" past the end).
+    // Offsets are checked against each other so a damaged column can't read
+    // outside its pool.
+    string_view view(uint32_t doc, MetadataField f) const {
+        if (doc >= numDocs) return string_view();
+        uint32_t begin = offsets[f][doc];
+        uint32_t end = offsets[f][doc + 1];
+        if (end < begin || end > offsets[f][numDocs]) return string_view();
+        return string_view(pools[f] + begin, end - begin);
+    }
+
+    // Copies one field out
+    string field(uint32_t doc, MetadataField f) const { return string(view(doc, f)); }
+};
+
+#endif
+
+/*
+    ========================================================================================
+    EDUCATIONAL SUMMARY: METADATA STORE
+    ========================================================================================
+
+    1. WHY?
+       - The engine used to parse every line of doc_metadata.txt into five
+         std::strings per doc: millions of allocations at start for fields that
+         are only ever read for the ~10 docs of a result page.
+       - A column per field (offsets + pool) is mapped as is and read on demand.
+
+    2. WHY COLUMNS, NOT ROWS?
+       - Category or date alone (e.g. to rebuild categories.bin) touches only that
+         column's pages, not every title and author list.
+*/
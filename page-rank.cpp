@@ -5,6 +5,8 @@
 #include <sstream>
 #include <cmath>
 #include <numeric>
+#include <cstdlib>
+#include "static_score_format.h"
 
 // --- CONFIGURATION ---
 const double DAMPING_FACTOR = 0.85;
@@ -16,7 +18,21 @@ struct Node {
     std::vector<int> outbound_links;
 };
 
-int main() {
+int main(int argc, char* argv[]) {
+    // static_scores.bin options: --q16 (16-bit values instead of float32),
+    // --fold W (store W * PageRank, W = the engine's PAGERANK_WEIGHT)
+    uint32_t encoding = STATIC_FLOAT32;
+    float foldWeight = 1.0f;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--q16") encoding = STATIC_QUANT16;
+        else if (arg == "--fold" && i + 1 < argc) foldWeight = (float)atof(argv[++i]);
+    }
+    if (!(foldWeight > 0.0f)) {
+        std::cerr << "Error: --fold needs a positive weight" << std::endl;
+        return 1;
+    }
+
     std::cout << "Loading Graph..." << std::endl;
     std::ifstream infile("C:\\Users\\Hank47\\Sem3\\Rummager\\graph.txt");
     if (!infile.is_open()) {
@@ -95,6 +111,11 @@ int main() {
     }
     outfile.close();
 
+    // Binary copy the engine maps instead of parsing the text
+    if (!writeStaticScores("static_scores.bin", buildStaticScores(PR, encoding, foldWeight))) {
+        std::cerr << "Warning: could not write static_scores.bin" << std::endl;
+    }
+
     std::cout << "Done." << std::endl;
     return 0;
 }
\ No newline at end of file
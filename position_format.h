@@ -0,0 +1,204 @@
+#ifndef POSITION_FORMAT_H
+#define POSITION_FORMAT_H
+
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+
+using namespace std;
+
+// ---------------------------------------------------------
+// POSITIONAL INDEX (Optional side files)
+// ---------------------------------------------------------
+// A position is a token's index in its document AFTER tokenization
+// (stopwords removed, words outside the lexicon still counted), so the
+// query "graph neural network" is a phrase iff its tokens sit at p, p+1, p+2.
+//
+// forward_positions.bin  (forward_indexer --positions; forward_index.bin is unchanged)
+//   per doc, same order as forward_index.bin:
+//     [docID][numPositions] then for each word of the forward record
+//     (same order) its 'freq' ascending positions as uint32
+//
+// inverted_positions.bin  (invert, when forward_positions.bin exists)
+//   [totalWords] then per word: [numPositions][positions of every posting, list order]
+//
+// barrel_N.pos  (create_barrels, next to barrel_N.bin)
+//   [PositionHeader]
+//   [Offset Table: uint64 x wordsPerBarrel]   (0 = no positions)
+//   per list (4-byte aligned):
+//     [PositionListHeader{count, numBlocks}]
+//     [uint32 byteOffset x numBlocks]          <- one per POSTING_BLOCK_SIZE postings
+//     [VByte data]
+//
+// Posting i of a list owns freq(i) positions, stored as the first position
+// followed by gaps, each as a VByte (7 bits per byte, high bit = more follows).
+// Blocks line up with the posting blocks of the barrel, so the reader only has
+// to skip the positions of earlier postings in the same block - and only for
+// docs that already survived the docID intersection.
+
+const uint32_t POSITION_MAGIC = 0x534F5052; // "RPOS"
+const uint32_t POSITION_VERSION = 1;
+const uint32_t POSITION_BLOCK_SIZE = 128;   // MUST equal POSTING_BLOCK_SIZE
+
+struct PositionHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t wordsPerBarrel;
+    uint32_t blockSize;
+};
+
+struct PositionListHeader {
+    uint32_t count;     // Postings (must match the barrel's list)
+    uint32_t numBlocks;
+};
+
+// --- VBYTE ---
+
+inline void vbyteEncode(uint32_t v, vector<uint8_t>& out) {
+    while (v >= 0x80) {
+        out.push_back((uint8_t)(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back((uint8_t)v);
+}
+
+// Decodes one value; stops at 'end' on corrupt input
+inline const uint8_t* vbyteDecode(const uint8_t* p, const uint8_t* end, uint32_t& v) {
+    v = 0;
+    int shift = 0;
+    while (p < end && shift < 35) {
+        uint8_t byte = *p++;
+        v |= (uint32_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) break;
+        shift += 7;
+    }
+    return p;
+}
+
+// Skips 'n' values without decoding them (a value ends on a byte < 0x80)
+inline const uint8_t* vbyteSkip(const uint8_t* p, const uint8_t* end, uint32_t n) {
+    while (n > 0 && p < end) {
+        if (!(*p++ & 0x80)) n--;
+    }
+    return p;
+}
+
+// --- ENCODING (create_barrels) ---
+
+// Appends one list. 'positions' holds every posting's positions back to back,
+// in posting order (freqs[i] of them for posting i).
+inline void encodePositionList(const uint32_t* freqs, const uint32_t* positions, uint32_t count,
+                               vector<uint8_t>& out) {
+    uint32_t numBlocks = (count + POSITION_BLOCK_SIZE - 1) / POSITION_BLOCK_SIZE;
+    PositionListHeader lh = { count, numBlocks };
+    const uint8_t* h = (const uint8_t*)&lh;
+    out.insert(out.end(), h, h + sizeof(lh));
+
+    size_t dirPos = out.size();
+    out.resize(out.size() + numBlocks * sizeof(uint32_t));
+
+    size_t dataStart = out.size();
+    size_t p = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        if (i % POSITION_BLOCK_SIZE == 0) {
+            uint32_t offset = (uint32_t)(out.size() - dataStart);
+            memcpy(out.data() + dirPos + (i / POSITION_BLOCK_SIZE) * sizeof(uint32_t), &offset, sizeof(offset));
+        }
+        uint32_t prev = 0;
+        for (uint32_t f = 0; f < freqs[i]; ++f, ++p) {
+            vbyteEncode(positions[p] - prev, out);
+            prev = positions[p];
+        }
+    }
+    while (out.size() % 4 != 0) out.push_back(0); // Keep the next list aligned
+}
+
+// --- READING (searchengine) ---
+
+// Read-only view of one list inside a mapped barrel_N.pos
+struct PositionListView {
+    uint32_t count = 0;
+    uint32_t numBlocks = 0;
+    const uint32_t* blockOffsets = nullptr;
+    const uint8_t* data = nullptr;
+    const uint8_t* end = nullptr;
+
+    bool empty() const { return count == 0; }
+
+    // Decodes the positions of posting 'ordinal' into 'out' (room for 'freq').
+    // 'before' = positions stored by earlier postings of the same block.
+    uint32_t decode(uint32_t ordinal, uint32_t before, uint32_t freq, uint32_t* out) const {
+        if (ordinal >= count) return 0;
+        const uint8_t* p = data + blockOffsets[ordinal / POSITION_BLOCK_SIZE];
+        p = vbyteSkip(p, end, before);
+
+        uint32_t n = 0, pos = 0;
+        while (n < freq && p < end) {
+            uint32_t gap;
+            p = vbyteDecode(p, end, gap);
+            pos += gap;
+            out[n++] = pos;
+        }
+        return n;
+    }
+};
+
+inline bool isPositionFile(const uint8_t* base, size_t size) {
+    if (size < sizeof(PositionHeader)) return false;
+    PositionHeader header;
+    memcpy(&header, base, sizeof(header));
+    return header.magic == POSITION_MAGIC;
+}
+
+// Locates a list in a mapped position file. Empty view on any out-of-range offset.
+inline PositionListView openPositionList(const uint8_t* base, size_t size, uint32_t localID) {
+    PositionListView view;
+    PositionHeader header;
+    memcpy(&header, base, sizeof(header));
+    if (localID >= header.wordsPerBarrel) return view;
+
+    size_t slot = sizeof(PositionHeader) + (size_t)localID * sizeof(uint64_t);
+    if (slot + sizeof(uint64_t) > size) return view;
+    uint64_t offset;
+    memcpy(&offset, base + slot, sizeof(offset));
+    if (offset == 0 || offset + sizeof(PositionListHeader) > size) return view;
+
+    PositionListHeader lh;
+    memcpy(&lh, base + offset, sizeof(lh));
+    if (lh.numBlocks != (lh.count + POSITION_BLOCK_SIZE - 1) / POSITION_BLOCK_SIZE) return view;
+    size_t dirStart = offset + sizeof(PositionListHeader);
+    size_t dataStart = dirStart + (size_t)lh.numBlocks * sizeof(uint32_t);
+    if (dataStart > size) return view;
+    const uint32_t* dir = (const uint32_t*)(base + dirStart);
+    for (uint32_t b = 0; b < lh.numBlocks; ++b) {
+        if (dataStart + dir[b] > size) return view;
+    }
+
+    view.count = lh.count;
+    view.numBlocks = lh.numBlocks;
+    view.blockOffsets = dir;
+    view.data = base + dataStart;
+    view.end = base + size;
+    return view;
+}
+
+#endif
+
+/*
+    ========================================================================================
+    EDUCATIONAL SUMMARY: POSITIONAL INDEX
+    ========================================================================================
+
+    1. WHY POSITIONS?
+       - Frequencies say HOW OFTEN a word occurs, not WHERE.
+       - "graph neural network" as a phrase vs. the three words scattered over an
+         abstract look identical to a frequency-only index.
+
+    2. COST CONTROL
+       - Positions are ~as large as the text itself, so they live in separate
+         barrel_N.pos files; without them the engine behaves exactly as before.
+       - Gaps + VByte keep them small (most gaps fit in one byte).
+       - The engine first intersects docIDs as usual and only then decodes
+         positions for the surviving docs: queries without phrases never touch them.
+*/
@@ -0,0 +1,265 @@
+#ifndef QUERY_SERVER_H
+#define QUERY_SERVER_H
+
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <cstdlib>
+#include <cerrno>
+#include <utility>
+#include <atomic>
+#include <csignal>
+#include "bounded_queue.h"
+
+#ifdef _WIN32
+    #ifndef NOMINMAX
+    #define NOMINMAX
+    #endif
+    #include <winsock2.h>
+    #include <ws2tcpip.h> // Link with -lws2_32
+    typedef SOCKET socket_t;
+    const socket_t NO_SOCKET = INVALID_SOCKET;
+    inline void closeSocket(socket_t s) { closesocket(s); }
+#else
+    #include <sys/socket.h>
+    #include <sys/select.h>
+    #include <poll.h>
+    #include <sys/un.h>
+    #include <netinet/in.h>
+    #include <arpa/inet.h>
+    #include <unistd.h>
+    #include <signal.h>
+    typedef int socket_t;
+    const socket_t NO_SOCKET = -1;
+    inline void closeSocket(socket_t s) { ::close(s); }
+#endif
+
+using namespace std;
+
+// ---------------------------------------------------------
+// LINE PROTOCOL SERVER (searchengine --serve)
+// ---------------------------------------------------------
+// Same protocol as stdin: one command per line in, one response out
+// ("--json" = one JSON object per line). A client may keep its connection
+// open for many commands; they are answered in order.
+//
+// Address: "7070" (TCP on 127.0.0.1), "0.0.0.0:7070" (TCP, any interface)
+// or "unix:/tmp/rummager.sock" (Unix domain socket, POSIX only).
+
+// One-time socket library setup (Winsock) and SIGPIPE off (POSIX): a client
+// hanging up mid-response must not kill the engine.
+inline bool initSockets() {
+#ifdef _WIN32
+    static bool ok = [] { WSADATA wsa; return WSAStartup(MAKEWORD(2, 2), &wsa) == 0; }();
+    return ok;
+#else
+    signal(SIGPIPE, SIG_IGN);
+    return true;
+#endif
+}
+
+const size_t MAX_LINE_BYTES = 64 << 10; // Longest command; a client past it is dropped
+const int STOP_POLL_MS = 500;           // How often a waiting connection checks for shutdown
+
+// --- SHUTDOWN (SIGINT / SIGTERM) ---
+// The handler only sets the flag; the accept loop and idle connections see it
+// within STOP_POLL_MS and the server winds down from there.
+inline atomic<bool> serverStopRequested{false};
+
+extern "C" inline void requestServerStop(int) { serverStopRequested.store(true); }
+
+inline void installStopSignals() {
+    signal(SIGINT, requestServerStop);
+    signal(SIGTERM, requestServerStop);
+}
+
+// --- LISTENING SOCKET ---
+class ServerSocket {
+private:
+    socket_t fd = NO_SOCKET;
+    string unixPath; // Removed again on close
+
+public:
+    ServerSocket() = default;
+    ~ServerSocket() { close(); }
+
+    ServerSocket(const ServerSocket&) = delete;
+    ServerSocket& operator=(const ServerSocket&) = delete;
+
+    bool listenOn(const string& address, int backlog = 128) {
+        close();
+        if (!initSockets()) return false;
+
+        if (address.rfind("unix:", 0) == 0) {
+#ifdef _WIN32
+            return false;
+#else
+            string path = address.substr(5);
+            sockaddr_un addr;
+            memset(&addr, 0, sizeof(addr));
+            if (path.empty() || path.size() >= sizeof(addr.sun_path)) return false;
+            addr.sun_family = AF_UNIX;
+            memcpy(addr.sun_path, path.c_str(), path.size());
+
+            fd = socket(AF_UNIX, SOCK_STREAM, 0);
+            if (fd == NO_SOCKET) return false;
+            ::unlink(path.c_str()); // Left over from a previous run
+            if (::bind(fd, (sockaddr*)&addr, sizeof(addr)) != 0 || ::listen(fd, backlog) != 0) {
+                close();
+                return false;
+            }
+            unixPath = path;
+            return true;
+#endif
+        }
+
+        string host = "127.0.0.1";
+        string port = address;
+        size_t colon = address.rfind(':');
+        if (colon != string::npos) {
+            host = address.substr(0, colon);
+            port = address.substr(colon + 1);
+        }
+        int portNum = atoi(port.c_str());
+        if (portNum <= 0 || portNum > 65535) return false;
+
+        sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons((uint16_t)portNum);
+        if (inet_pton(AF_INET, host.c_str(), &addr.sin_addr) != 1) return false;
+
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd == NO_SOCKET) return false;
+        int yes = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, (const char*)&yes, sizeof(yes));
+        if (::bind(fd, (sockaddr*)&addr, sizeof(addr)) != 0 || ::listen(fd, backlog) != 0) {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    // Waits up to 'ms' for a client. NO_SOCKET on timeout, so the caller's
+    // loop gets a turn between clients.
+    socket_t acceptFor(int ms) {
+        if (fd == NO_SOCKET) return NO_SOCKET;
+        fd_set ready;
+        FD_ZERO(&ready);
+        FD_SET(fd, &ready);
+        timeval tv;
+        tv.tv_sec = ms / 1000;
+        tv.tv_usec = (ms % 1000) * 1000;
+        if (select((int)fd + 1, &ready, nullptr, nullptr, &tv) <= 0) return NO_SOCKET;
+        return accept(fd, nullptr, nullptr);
+    }
+
+    void close() {
+        if (fd != NO_SOCKET) closeSocket(fd);
+        fd = NO_SOCKET;
+#ifndef _WIN32
+        if (!unixPath.empty()) ::unlink(unixPath.c_str());
+#endif
+        unixPath.clear();
+    }
+};
+
+// --- ONE CLIENT ---
+class Connection {
+private:
+    socket_t fd = NO_SOCKET;
+    string buffer; // Bytes received past the last full line
+    const atomic<bool>* stop; // Set = stop waiting for the client (server shutting down)
+
+    // Waits until the client sent something; false if 'stop' was set meanwhile
+    bool waitReadable() {
+        while (!(stop && stop->load())) {
+#ifdef _WIN32
+            fd_set ready;
+            FD_ZERO(&ready);
+            FD_SET(fd, &ready);
+            timeval tv;
+            tv.tv_sec = STOP_POLL_MS / 1000;
+            tv.tv_usec = (STOP_POLL_MS % 1000) * 1000;
+            if (select(0, &ready, nullptr, nullptr, &tv) != 0) return true; // Errors fall through to recv
+#else
+            pollfd p = { fd, POLLIN, 0 }; // poll: client fds can be past FD_SETSIZE
+            int r = poll(&p, 1, STOP_POLL_MS);
+            if (r > 0 || (r < 0 && errno != EINTR)) return true; // A signal just loops to the stop check
+#endif
+        }
+        return false;
+    }
+
+public:
+    explicit Connection(socket_t s, const atomic<bool>* stopFlag = nullptr) : fd(s), stop(stopFlag) {}
+    ~Connection() { if (fd != NO_SOCKET) closeSocket(fd); }
+
+    Connection(const Connection&) = delete;
+    Connection& operator=(const Connection&) = delete;
+
+    // Next line without its '\n' (and '\r'). False once the client is gone,
+    // sent a line longer than MAX_LINE_BYTES, or the server is stopping.
+    bool readLine(string& line) {
+        size_t scanned = 0;
+        while (true) {
+            size_t nl = buffer.find('\n', scanned);
+            if (nl != string::npos) {
+                if (nl > MAX_LINE_BYTES) return false;
+                line.assign(buffer, 0, nl);
+                buffer.erase(0, nl + 1);
+                if (!line.empty() && line.back() == '\r') line.pop_back();
+                return true;
+            }
+            scanned = buffer.size();
+            if (scanned > MAX_LINE_BYTES) return false; // No newline in sight: not our protocol
+            if (!waitReadable()) return false;
+
+            char chunk[4096];
+            int got = (int)recv(fd, chunk, sizeof(chunk), 0);
+            if (got <= 0) {
+                if (buffer.empty()) return false;
+                line.swap(buffer); // Last line without a newline
+                buffer.clear();
+                return true;
+            }
+            buffer.append(chunk, (size_t)got);
+        }
+    }
+
+    bool writeAll(const string& data) {
+        size_t sent = 0;
+        while (sent < data.size()) {
+#if defined(_WIN32) || !defined(MSG_NOSIGNAL)
+            int n = (int)send(fd, data.data() + sent, (int)(data.size() - sent), 0);
+#else
+            int n = (int)send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+#endif
+            if (n <= 0) return false;
+            sent += (size_t)n;
+        }
+        return true;
+    }
+};
+
+#endif
+
+/*
+    ========================================================================================
+    EDUCATIONAL SUMMARY: QUERY SERVER
+    ========================================================================================
+
+    1. WHY?
+       - The stdin loop answers one command at a time, so a slow "/date" query made
+         every "/suggest" keystroke queued behind it wait.
+       - A socket lets many clients talk to one loaded engine at once.
+
+    2. SHAPE
+       - One accept loop, a fixed pool of workers, a bounded queue between them.
+       - A command longer than MAX_LINE_BYTES drops its connection, so a client that
+         never sends a newline can't grow a worker's buffer without limit.
+       - SIGINT / SIGTERM stop the accept loop, drop idle connections, close the
+         queue and join the workers.
+       - The index is read-only while serving, so workers share it without locks;
+         only the caches (which have their own mutexes) and per-thread scratch change.
+*/
@@ -7,7 +7,7 @@ echo Building C++ Tools...
 g++ -O3 -std=c++17 add_document.cpp -o add_document.exe
 g++ -O3 -std=c++17 invert.cpp -o invert.exe
 g++ -O3 -std=c++17 create_barrels.cpp -o create_barrels.exe
-g++ -O3 -std=c++17 searchengine.cpp -o searchengine.exe
+g++ -O3 -std=c++17 searchengine.cpp -o searchengine.exe -lws2_32
 
 echo Building Frontend...
 cd frontend
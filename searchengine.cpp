@@ -7,31 +7,1066 @@
 #include <cmath>
 #include <algorithm>
 #include "common.h"
+#include "mapped_file.h"
+#include "barrel_format.h"
+#include "position_format.h"
+#include "category_format.h"
+#include "date_format.h"
+#include "lexicon_format.h"
+#include "metadata_format.h"
+#include "static_score_format.h"
+#include "simd_intersect.h"
+#include "query_server.h"
+#include "json_writer.h"
 #include <cstdint>
+#include <cstring>
 #include <chrono>
 #include <filesystem> // C++17
-#include <queue> // NEW
+#include <random>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <exception>
+#include <functional>
+#ifdef __linux__
+#include <sys/inotify.h> // Hot swap: wakes the watcher when swap.signal is written
+#include <poll.h>
+#endif
 
 using namespace std;
 namespace fs = std::filesystem;
 
 // --- CONFIGURATION ---
-string BARREL_DIR = "C:\\Users\\Hank47\\Sem3\\Rummager\\barrels\\";
+const string BARREL_DIR = "C:\\Users\\Hank47\\Sem3\\Rummager\\barrels\\";
 const string LEXICON_FILE = "C:\\Users\\Hank47\\Sem3\\Rummager\\lexicon.bin";
 const string LENGTHS_FILE = "C:\\Users\\Hank47\\Sem3\\Rummager\\doc_lengths.bin";
+const string DATES_FILE = "C:\\Users\\Hank47\\Sem3\\Rummager\\doc_dates.bin";
 const string META_FILE = "C:\\Users\\Hank47\\Sem3\\Rummager\\doc_metadata.txt";
+const string META_STORE_FILE = "C:\\Users\\Hank47\\Sem3\\Rummager\\doc_metadata.bin";
 const string PAGERANK_FILE = "C:\\Users\\Hank47\\Sem3\\Rummager\\pagerank_scores.txt";
+const string STATIC_SCORES_FILE = "C:\\Users\\Hank47\\Sem3\\Rummager\\static_scores.bin";
 const string TRIE_FILE = "C:\\Users\\Hank47\\Sem3\\Rummager\\trie.bin"; // NEW
 
 const uint32_t WORDS_PER_BARREL = 50000;
 const double K1 = 1.5;
 const double B = 0.75;
 const double PAGERANK_WEIGHT = 50.0;
+const double PROXIMITY_WEIGHT = 1.0; // Max boost when all query terms are adjacent
+const size_t PARALLEL_MIN_COST = 1 << 16; // Postings walked per extra thread before a query is split
 
 struct Posting { uint32_t docID; uint32_t freq; };
 struct Result { uint32_t docID; double score; };
 
-// NEW: Struct to hold full paper details
+// Zero-copy view over a posting list that lives inside a mapped barrel
+struct PostingSpan {
+    const Posting* ptr = nullptr;
+    uint32_t count = 0;
+
+    const Posting* begin() const { return ptr; }
+    const Posting* end() const { return ptr + count; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    const Posting& operator[](size_t i) const { return ptr[i]; }
+};
+
+// A v2 list decoded once, block layout kept (block b = [b*128, b*128+128))
+struct DecodedList {
+    vector<uint32_t> docs;
+    vector<uint32_t> freqs;
+
+    size_t bytes() const { return (docs.capacity() + freqs.capacity()) * sizeof(uint32_t) + sizeof(*this); }
+};
+
+// A term's posting list where it lives in the barrel:
+// v1 barrels expose raw postings, v2 barrels expose compressed blocks.
+// 'decoded' (v2 only) = the same list from the posting cache, read in place.
+struct PostingListRef {
+    PostingSpan raw;
+    BlockListView blocks;
+    bool compressed = false;
+    const DecodedList* decoded = nullptr;
+
+    uint32_t size() const { return compressed ? blocks.count : raw.count; }
+    bool empty() const { return size() == 0; }
+};
+
+// Appends every docID of a list to 'out' (decoding v2 blocks as needed)
+void appendDocIDs(const PostingListRef& ref, vector<uint32_t>& out) {
+    size_t start = out.size();
+    out.resize(start + ref.size());
+    if (!ref.compressed) {
+        for (uint32_t i = 0; i < ref.raw.count; ++i) out[start + i] = ref.raw[i].docID;
+        return;
+    }
+    uint32_t freqs[POSTING_BLOCK_SIZE];
+    for (uint32_t b = 0; b < ref.blocks.numBlocks; ++b) {
+        ref.blocks.decodeBlock(b, out.data() + start + (size_t)b * POSTING_BLOCK_SIZE, freqs);
+    }
+}
+
+static_assert(sizeof(Posting) == 2 * sizeof(uint32_t), "Kernels read v1 postings with stride 2");
+static_assert(sizeof(BlockEntry) == 2 * sizeof(uint32_t), "Skip search reads the block directory with stride 2");
+
+// Final ranking order: higher score first, lower docID breaks ties.
+// Every path (exhaustive or pruned) uses this so their results are identical.
+inline bool rankedBefore(const Result& a, const Result& b) {
+    if (a.score != b.score) return a.score > b.score;
+    return a.docID < b.docID;
+}
+
+// --- BOUNDED TOP-K ---
+// Keeps the best 'capacity' results under 'better' in a heap whose front is
+// the worst result kept so far: O(n log k) instead of sorting all n matches.
+template<typename Better>
+class TopK {
+private:
+    vector<Result> heap;
+    size_t capacity;
+    Better better;
+
+public:
+    TopK(size_t k, Better cmp) : capacity(k), better(cmp) {}
+
+    bool full() const { return heap.size() >= capacity; }
+    const Result& worst() const { return heap.front(); }
+
+    void push(const Result& r) {
+        if (capacity == 0) return;
+        if (heap.size() < capacity) {
+            heap.push_back(r);
+            push_heap(heap.begin(), heap.end(), better);
+        } else if (better(r, heap.front())) {
+            pop_heap(heap.begin(), heap.end(), better);
+            heap.back() = r;
+            push_heap(heap.begin(), heap.end(), better);
+        }
+    }
+
+    // Best first. Leaves the collector empty.
+    vector<Result> take() {
+        sort_heap(heap.begin(), heap.end(), better);
+        return move(heap);
+    }
+};
+
+// --- SCORE ACCUMULATOR (OR queries) ---
+// Term-at-a-time scoring keeps one running sum per candidate doc:
+//   dense  : one slot per doc in the collection, indexed by docID. Broad
+//            queries touch much of it anyway; only touched slots are reset.
+//   sparse : (docID, partial score) pairs, sorted and summed at the end.
+//            Selective queries never walk a collection-sized array.
+// Both buffers outlive the query, so a warm query allocates nothing.
+const size_t SPARSE_RATIO = 16; // Sparse when postings * 16 < collection size
+
+class ScoreAccumulator {
+private:
+    vector<double> dense;
+    vector<uint32_t> touched;
+    vector<Result> sparse;
+    uint32_t numDocs = 0;
+    bool useDense = false;
+
+public:
+    void begin(uint32_t docs, size_t totalPostings) {
+        numDocs = docs;
+        useDense = totalPostings * SPARSE_RATIO >= docs;
+        if (useDense && dense.size() != docs) dense.assign(docs, 0.0); // Only when the collection changes
+        touched.clear();
+        sparse.clear();
+    }
+
+    bool isDense() const { return useDense; }
+
+    // Term scores are strictly positive, so 0.0 marks an untouched slot
+    inline void add(uint32_t docID, double score) {
+        if (docID >= numDocs) return;
+        if (useDense) {
+            double& slot = dense[docID];
+            if (slot == 0.0) touched.push_back(docID);
+            slot += score;
+        } else {
+            sparse.push_back({docID, score});
+        }
+    }
+
+    // Hands every (docID, total) to 'emit' and leaves the accumulator clean
+    template<typename Emit>
+    void drain(Emit&& emit) {
+        if (useDense) {
+            for (uint32_t docID : touched) {
+                emit(Result{docID, dense[docID]});
+                dense[docID] = 0.0;
+            }
+            touched.clear();
+            return;
+        }
+
+        sort(sparse.begin(), sparse.end(), [](const Result& a, const Result& b) { return a.docID < b.docID; });
+        size_t i = 0;
+        while (i < sparse.size()) {
+            Result total = sparse[i++];
+            while (i < sparse.size() && sparse[i].docID == total.docID) total.score += sparse[i++].score;
+            emit(total);
+        }
+        sparse.clear();
+    }
+};
+
+// --- POSTING CACHE ---
+// Fully decoded v2 lists of hot terms, so their blocks are read in place
+// instead of being StreamVByte-decoded again by every query.
+//  - Admission (TinyLFU): a count-min sketch estimates how often each term
+//    was asked for lately; a list is only decoded and cached once it has
+//    been requested CACHE_ADMIT_FREQUENCY times, so one-off terms never push
+//    out hot ones.
+//  - Eviction (segmented LRU): new entries start in 'probation'; a hit there
+//    promotes them to 'protected' (80% of the budget). A scan over many
+//    distinct terms only churns probation.
+// Entries are shared_ptr: a query pins the lists it reads, so eviction or a
+// hot swap never frees a list under a running query. clear() bumps the
+// generation, and lists decoded before it are refused by insert().
+const size_t DEFAULT_CACHE_MB = 64;
+const uint32_t CACHE_MIN_BLOCKS = 2;       // Shorter lists decode faster than a lookup pays off
+const uint32_t CACHE_ADMIT_FREQUENCY = 2;
+const double CACHE_PROTECTED_SHARE = 0.8;
+
+// Count-min sketch of recent request counts (4 rows of 8-bit counters).
+// Counters are halved every SKETCH_SAMPLE increments, so old popularity fades.
+class FrequencySketch {
+private:
+    static const uint32_t WIDTH = 1 << 14;
+    static const uint32_t ROWS = 4;
+    static const uint32_t SKETCH_SAMPLE = WIDTH * 10;
+    vector<uint8_t> counters = vector<uint8_t>(WIDTH * ROWS, 0);
+    uint32_t additions = 0;
+
+    static uint32_t slot(uint32_t key, uint32_t row) {
+        static const uint32_t SEEDS[ROWS] = { 0x9E3779B1u, 0x85EBCA77u, 0xC2B2AE3Du, 0x27D4EB2Fu };
+        uint32_t h = (key + row) * SEEDS[row];
+        h ^= h >> 15;
+        return row * WIDTH + (h & (WIDTH - 1));
+    }
+
+public:
+    // Records one request and returns the new estimate
+    uint32_t increment(uint32_t key) {
+        uint32_t estimate = UINT32_MAX;
+        for (uint32_t r = 0; r < ROWS; ++r) {
+            uint8_t& c = counters[slot(key, r)];
+            if (c < 255) c++;
+            estimate = min(estimate, (uint32_t)c);
+        }
+        if (++additions >= SKETCH_SAMPLE) {
+            for (uint8_t& c : counters) c >>= 1;
+            additions = 0;
+        }
+        return estimate;
+    }
+
+    void clear() {
+        fill(counters.begin(), counters.end(), 0);
+        additions = 0;
+    }
+};
+
+struct PostingCacheStats {
+    size_t budgetBytes = 0;
+    size_t bytes = 0;
+    size_t entries = 0;
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+
+    double hitRate() const { return (hits + misses) ? (double)hits / (hits + misses) : 0.0; }
+};
+
+class PostingCache {
+private:
+    struct Entry {
+        uint32_t wordID;
+        shared_ptr<const DecodedList> list;
+        size_t bytes;
+        bool isProtected;
+    };
+    using Segment = std::list<Entry>; // Front = most recently used
+
+    Segment probation, protectedSeg;
+    unordered_map<uint32_t, Segment::iterator> index;
+    FrequencySketch sketch;
+    size_t budget = DEFAULT_CACHE_MB * 1024 * 1024;
+    size_t bytes = 0, protectedBytes = 0;
+    uint64_t hits = 0, misses = 0, evictions = 0;
+    uint64_t generation = 0;
+    mutable mutex lock;
+
+    void evictOne() {
+        Segment& victims = probation.empty() ? protectedSeg : probation;
+        Entry& e = victims.back();
+        bytes -= e.bytes;
+        if (e.isProtected) protectedBytes -= e.bytes;
+        index.erase(e.wordID);
+        victims.pop_back();
+        evictions++;
+    }
+
+    void fitBudget() {
+        while (bytes > budget && !index.empty()) evictOne();
+    }
+
+public:
+    // Cached list, or nullptr. On a miss 'admit' says whether the caller should
+    // decode the list and insert() it under 'gen'.
+    shared_ptr<const DecodedList> lookup(uint32_t wordID, bool& admit, uint64_t& gen) {
+        lock_guard<mutex> guard(lock);
+        gen = generation;
+        admit = false;
+        uint32_t frequency = sketch.increment(wordID);
+
+        auto it = index.find(wordID);
+        if (it == index.end()) {
+            misses++;
+            admit = budget > 0 && frequency >= CACHE_ADMIT_FREQUENCY;
+            return nullptr;
+        }
+
+        hits++;
+        Segment::iterator e = it->second;
+        if (e->isProtected) {
+            protectedSeg.splice(protectedSeg.begin(), protectedSeg, e);
+        } else {
+            // Second hit: promote, demoting the coldest protected entries if needed
+            e->isProtected = true;
+            protectedBytes += e->bytes;
+            protectedSeg.splice(protectedSeg.begin(), probation, e);
+            size_t protectedBudget = (size_t)(budget * CACHE_PROTECTED_SHARE);
+            while (protectedBytes > protectedBudget && protectedSeg.size() > 1) {
+                Segment::iterator cold = prev(protectedSeg.end());
+                cold->isProtected = false;
+                protectedBytes -= cold->bytes;
+                probation.splice(probation.begin(), protectedSeg, cold);
+            }
+        }
+        return e->list;
+    }
+
+    void insert(uint32_t wordID, shared_ptr<const DecodedList> list, uint64_t gen) {
+        lock_guard<mutex> guard(lock);
+        size_t size = list->bytes();
+        if (gen != generation || size > budget || index.count(wordID)) return;
+        probation.push_front({wordID, move(list), size, false});
+        index[wordID] = probation.begin();
+        bytes += size;
+        fitBudget();
+    }
+
+    // Drops every entry (hot swap). Running queries keep their pinned lists.
+    void clear() {
+        lock_guard<mutex> guard(lock);
+        probation.clear();
+        protectedSeg.clear();
+        index.clear();
+        sketch.clear();
+        bytes = protectedBytes = 0;
+        generation++;
+    }
+
+    void setBudget(size_t budgetBytes) {
+        lock_guard<mutex> guard(lock);
+        budget = budgetBytes;
+        fitBudget();
+    }
+
+    PostingCacheStats stats() const {
+        lock_guard<mutex> guard(lock);
+        PostingCacheStats st;
+        st.budgetBytes = budget;
+        st.bytes = bytes;
+        st.entries = index.size();
+        st.hits = hits;
+        st.misses = misses;
+        st.evictions = evictions;
+        return st;
+    }
+};
+
+// --- RESULT CACHE ---
+// Ranked results of recent queries, keyed on the normalized query (sorted,
+// deduped tokens, phrases, filters, sort mode). An entry holds the best
+// 'depth' results, so any page inside that window is served from it; a
+// deeper page recomputes and replaces it. Entries expire after a TTL and
+// are evicted LRU once the entry or byte limit is hit.
+// invalidate() bumps a generation (hot swap, document ingestion): older
+// entries are never served again and results computed before it are
+// refused by insert().
+const size_t DEFAULT_RESULT_CACHE_MB = 16;
+const size_t RESULT_CACHE_MAX_ENTRIES = 10000;
+const long long DEFAULT_RESULT_TTL_S = 300;
+
+struct ResultCacheStats {
+    size_t budgetBytes = 0;
+    size_t bytes = 0;
+    size_t entries = 0;
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+    uint64_t generation = 0;
+
+    double hitRate() const { return (hits + misses) ? (double)hits / (hits + misses) : 0.0; }
+};
+
+struct CachedResults {
+    vector<Result> top;            // Best first
+    bool complete = false;         // Fewer matches than asked for: every page is in 'top'
+    bool positionsMissing = false;
+};
+
+class ResultCache {
+private:
+    struct Entry {
+        string key;
+        shared_ptr<const CachedResults> results;
+        size_t bytes;
+        chrono::steady_clock::time_point stored;
+        uint64_t generation;
+    };
+
+    std::list<Entry> lru; // Front = most recently used
+    unordered_map<string, std::list<Entry>::iterator> index;
+    size_t budget = DEFAULT_RESULT_CACHE_MB * 1024 * 1024;
+    chrono::seconds ttl = chrono::seconds(DEFAULT_RESULT_TTL_S);
+    size_t bytes = 0;
+    uint64_t hits = 0, misses = 0, evictions = 0;
+    uint64_t generation = 0;
+    mutable mutex lock;
+
+    void erase(std::list<Entry>::iterator e) {
+        bytes -= e->bytes;
+        index.erase(e->key);
+        lru.erase(e);
+    }
+
+    void fitBudget() {
+        while (!lru.empty() && (bytes > budget || lru.size() > RESULT_CACHE_MAX_ENTRIES)) {
+            erase(prev(lru.end()));
+            evictions++;
+        }
+    }
+
+public:
+    // Entry holding at least the first 'need' results, or nullptr.
+    // 'gen' is what a recomputed result must be inserted under.
+    shared_ptr<const CachedResults> lookup(const string& key, size_t need, uint64_t& gen) {
+        lock_guard<mutex> guard(lock);
+        gen = generation;
+        auto it = index.find(key);
+        if (it == index.end()) { misses++; return nullptr; }
+
+        auto e = it->second;
+        bool expired = chrono::steady_clock::now() - e->stored > ttl;
+        if (expired || e->generation != generation) { erase(e); misses++; return nullptr; }
+        if (!e->results->complete && e->results->top.size() < need) { misses++; return nullptr; }
+
+        lru.splice(lru.begin(), lru, e);
+        hits++;
+        return e->results;
+    }
+
+    void insert(const string& key, shared_ptr<const CachedResults> results, uint64_t gen) {
+        lock_guard<mutex> guard(lock);
+        if (gen != generation || budget == 0) return;
+        auto it = index.find(key);
+        if (it != index.end()) erase(it->second);
+
+        size_t size = sizeof(Entry) + key.size() + results->top.size() * sizeof(Result);
+        lru.push_front({key, move(results), size, chrono::steady_clock::now(), gen});
+        index[key] = lru.begin();
+        bytes += size;
+        fitBudget();
+    }
+
+    // Hot swap / ingestion: nothing cached so far may be served again
+    uint64_t invalidate() {
+        lock_guard<mutex> guard(lock);
+        lru.clear();
+        index.clear();
+        bytes = 0;
+        return ++generation;
+    }
+
+    void configure(size_t budgetBytes, long long ttlSeconds) {
+        lock_guard<mutex> guard(lock);
+        budget = budgetBytes;
+        ttl = chrono::seconds(ttlSeconds);
+        fitBudget();
+    }
+
+    ResultCacheStats stats() const {
+        lock_guard<mutex> guard(lock);
+        ResultCacheStats st;
+        st.budgetBytes = budget;
+        st.bytes = bytes;
+        st.entries = lru.size();
+        st.hits = hits;
+        st.misses = misses;
+        st.evictions = evictions;
+        st.generation = generation;
+        return st;
+    }
+};
+
+// --- POSITIONAL PLAN (phrases / proximity) ---
+struct PhraseTerm {
+    uint32_t term;    // Index into the query's terms
+    uint32_t offset;  // Token offset inside the phrase
+};
+
+struct PositionalPlan {
+    vector<vector<PhraseTerm>> phrases;   // Every phrase must occur in the doc
+    vector<PositionListView> lists;       // Per query term
+    vector<uint32_t> decode;              // Terms whose positions are needed
+    bool proximity = false;               // Boost docs whose terms sit close together
+
+    bool active() const { return !phrases.empty() || proximity; }
+};
+
+// --- QUERY OPTIONS / PAGING ---
+const size_t DEFAULT_LIMIT = 120;
+const size_t MAX_LIMIT = 1000;
+const size_t MAX_OFFSET = 100000;
+
+struct QueryOptions {
+    string categoryFilter;
+    uint32_t sinceDay = NO_DATE;      // "/since:" (inclusive), NO_DATE = open
+    uint32_t untilDay = UINT32_MAX;   // "/until:" (inclusive)
+    bool sortByDate = false;
+    bool exhaustive = false;  // Skip dynamic pruning (verification)
+    bool disjunctive = false; // OR: rank docs matching any term
+    bool proximity = false;   // Proximity boost without a quoted phrase
+    size_t offset = 0;        // Results to skip (page start)
+    size_t limit = DEFAULT_LIMIT;
+};
+
+// Where a query's time went, in microseconds ("--json": tokenize_us ...).
+// DAAT and Block-Max WAND score each doc the moment every cursor agrees on it,
+// so for AND queries BM25 is part of 'intersect'; 'score' is the separate
+// scoring pass of OR queries (accumulated sums + static scores). A split
+// query reports its slowest range per stage. A result-cache hit is all zero.
+struct QueryTimings {
+    double tokenize = 0;  // Tokens + lexicon lookups
+    double fetch = 0;     // Posting lists located, category set and positions planned
+    double intersect = 0; // Walking the lists
+    double score = 0;
+    double sort = 0;      // Top-k ordered, split ranges merged
+
+    void takeSlowest(const QueryTimings& part) {
+        tokenize = max(tokenize, part.tokenize);
+        fetch = max(fetch, part.fetch);
+        intersect = max(intersect, part.intersect);
+        score = max(score, part.score);
+        sort = max(sort, part.sort);
+    }
+};
+
+// Charges the time since the previous lap to one stage
+class StageClock {
+private:
+    chrono::steady_clock::time_point mark = chrono::steady_clock::now();
+
+public:
+    double lap() {
+        auto now = chrono::steady_clock::now();
+        double us = chrono::duration<double, micro>(now - mark).count();
+        mark = now;
+        return us;
+    }
+};
+
+struct ResultPage {
+    vector<Result> results;
+    bool hasMore = false;     // Another page exists after this one
+    bool positionsMissing = false; // Phrase asked for, but the barrels have no positions
+    QueryTimings timings;
+};
+
+// --- POSTING CURSOR ---
+// Forward-only iterator over one posting list in docID order, for both formats.
+//  - v1: galloping search directly over the mapped postings.
+//  - v2: "shallow" moves only read the block directory (the skip list);
+//        a block is decoded the first time a posting inside it is needed
+//        (or read in place if the list sits in the posting cache).
+// Targets passed to shallowSeek/nextGEQ must never decrease.
+class PostingCursor {
+private:
+    const PostingListRef* list = nullptr;
+    size_t index = 0;                // v1: position in the raw postings
+    uint32_t block = 0;              // v2: current block (numBlocks = exhausted)
+    uint32_t decoded = UINT32_MAX;   // v2: block currently held in docs/freqs
+    uint32_t pos = 0;                // v2: position inside the decoded block
+    uint32_t count = 0;              // v2: postings in the decoded block
+    const uint32_t* docs = docBuf;   // v2: current block (docBuf or the cached list)
+    const uint32_t* freqs = freqBuf;
+    uint32_t docBuf[POSTING_BLOCK_SIZE];
+    uint32_t freqBuf[POSTING_BLOCK_SIZE];
+
+    void loadBlock(uint32_t b) {
+        if (list->decoded) {
+            size_t start = (size_t)b * POSTING_BLOCK_SIZE;
+            count = list->blocks.blockSize(b);
+            docs = list->decoded->docs.data() + start;
+            freqs = list->decoded->freqs.data() + start;
+        } else {
+            count = list->blocks.decodeBlock(b, docBuf, freqBuf);
+            docs = docBuf;
+            freqs = freqBuf;
+        }
+        decoded = b;
+        pos = 0;
+    }
+
+public:
+    static const uint32_t END = UINT32_MAX;
+
+    PostingCursor() = default;
+    PostingCursor(const PostingCursor&) = delete; // 'docs' may point into this cursor
+    PostingCursor& operator=(const PostingCursor&) = delete;
+
+    void reset(const PostingListRef* l) {
+        list = l;
+        index = 0;
+        block = 0;
+        decoded = UINT32_MAX;
+        pos = 0;
+    }
+
+    // v2 only: moves to the first block that may contain 'target'. No decoding.
+    bool shallowSeek(uint32_t target) {
+        const BlockListView& v = list->blocks;
+        block = (uint32_t)gallopGEQ<2>((const uint32_t*)v.dir, v.numBlocks, block, target);
+        return block < v.numBlocks;
+    }
+
+    uint32_t blockLastDoc() const { return list->blocks.dir[block].lastDocID; }
+    const BlockBound& blockBound() const { return list->blocks.bounds[block]; }
+
+    // First docID >= target, or END. Decodes at most one block.
+    uint32_t nextGEQ(uint32_t target) {
+        if (!list->compressed) {
+            index = gallopGEQ<2>((const uint32_t*)list->raw.ptr, list->raw.count, index, target);
+            return (index < list->raw.count) ? list->raw[index].docID : END;
+        }
+        // Fast path: target is still inside the decoded block
+        if (decoded == block && target <= docs[count - 1]) {
+            if (docs[pos] < target) pos = (uint32_t)findGEQ(docs, count, pos, target);
+            return docs[pos];
+        }
+        if (!shallowSeek(target)) return END;
+        if (decoded != block) loadBlock(block);
+        pos = (uint32_t)findGEQ(docs, count, pos, target); // In-block: lastDocID >= target
+        return docs[pos];
+    }
+
+    // Next posting after the current one (cursor must already be positioned)
+    uint32_t next() {
+        if (!list->compressed) {
+            return (++index < list->raw.count) ? list->raw[index].docID : END;
+        }
+        if (pos + 1 < count) return docs[++pos];
+        if (block + 1 >= list->blocks.numBlocks) { block = list->blocks.numBlocks; return END; }
+        block++;
+        loadBlock(block);
+        return docs[0];
+    }
+
+    uint32_t freq() const {
+        return list->compressed ? freqs[pos] : list->raw[index].freq;
+    }
+
+    // Index of the current posting in its list
+    uint32_t ordinal() const {
+        return list->compressed ? block * POSTING_BLOCK_SIZE + pos : (uint32_t)index;
+    }
+
+    // Positions stored by the earlier postings of the current block (see position_format.h)
+    uint32_t positionsBefore() const {
+        uint32_t n = 0;
+        if (list->compressed) {
+            for (uint32_t i = 0; i < pos; ++i) n += freqs[i];
+        } else {
+            for (size_t i = index - index % POSTING_BLOCK_SIZE; i < index; ++i) n += list->raw[i].freq;
+        }
+        return n;
+    }
+};
+
+// --- DOC FILTER ---
+// A docID set that joins the intersection like one more posting list
+// ("/cat:"): a sorted list (zero-copy from categories.bin, or a merged copy)
+// or a bitmap. Targets passed to nextGEQ must never decrease until rewind().
+class DocFilter {
+private:
+    const uint32_t* docs = nullptr;  // List: ascending docIDs
+    uint32_t count = 0;
+    const uint64_t* bits = nullptr;  // Bitmap: bit d = doc d
+    uint32_t limit = 0;              // docIDs >= limit never match
+    size_t index = 0;                // List cursor
+    vector<uint32_t> ownedDocs;      // Unions of several categories
+    vector<uint64_t> ownedBits;
+
+    static uint32_t lowestBit(uint64_t word) {
+#if defined(__GNUC__)
+        return (uint32_t)__builtin_ctzll(word);
+#else
+        uint32_t n = 0;
+        while (!(word & 1)) { word >>= 1; n++; }
+        return n;
+#endif
+    }
+
+public:
+    static const uint32_t END = UINT32_MAX;
+
+    DocFilter() = default;
+    DocFilter(const DocFilter&) = delete; // Views may point into owned storage
+    DocFilter& operator=(const DocFilter&) = delete;
+
+    void setList(const uint32_t* d, uint32_t n, uint32_t docLimit) {
+        docs = d; count = n; bits = nullptr; limit = docLimit; index = 0;
+    }
+    void setBitmap(const uint64_t* b, uint32_t docLimit) {
+        docs = nullptr; count = 0; bits = b; limit = docLimit; index = 0;
+    }
+    void ownList(vector<uint32_t>&& d, uint32_t docLimit) {
+        ownedDocs = move(d);
+        setList(ownedDocs.data(), (uint32_t)ownedDocs.size(), docLimit);
+    }
+    void ownBitmap(vector<uint64_t>&& b, uint32_t docLimit) {
+        ownedBits = move(b);
+        setBitmap(ownedBits.data(), docLimit);
+    }
+    // Own cursor over another filter's set (one per worker of a split query)
+    void viewOf(const DocFilter& other) {
+        docs = other.docs; count = other.count; bits = other.bits; limit = other.limit; index = 0;
+    }
+
+    bool empty() const { return bits == nullptr && count == 0; }
+    void rewind() { index = 0; }
+
+    bool contains(uint32_t docID) const {
+        if (docID >= limit) return false;
+        if (bits) return (bits[docID / 64] >> (docID % 64)) & 1;
+        return binary_search(docs, docs + count, docID);
+    }
+
+    // First member >= target, or END
+    uint32_t nextGEQ(uint32_t target) {
+        if (target >= limit) return END;
+        if (!bits) {
+            index = gallopGEQ<1>(docs, count, index, target);
+            return (index < count && docs[index] < limit) ? docs[index] : END;
+        }
+        size_t w = target / 64;
+        uint64_t word = bits[w] & (~0ULL << (target % 64));
+        size_t words = ((size_t)limit + 63) / 64;
+        while (word == 0) {
+            if (++w >= words) return END;
+            word = bits[w];
+        }
+        uint32_t docID = (uint32_t)(w * 64 + lowestBit(word));
+        return docID < limit ? docID : END;
+    }
+};
+
+// Everything a query restricts docs by, checked during the intersection
+struct QueryFilter {
+    DocFilter* category = nullptr;    // "/cat:" set, nullptr = any
+    uint32_t since = NO_DATE;         // Day range, inclusive (see date_format.h)
+    uint32_t until = UINT32_MAX;
+    uint32_t firstDoc = 0;            // docID range [firstDoc, endDoc): one worker's share
+    uint32_t endDoc = UINT32_MAX;     //   of a split query, everything by default
+
+    bool dated() const { return since != NO_DATE || until != UINT32_MAX; }
+};
+
+// --- RANGE POOL (intra-query parallelism) ---
+// Long-lived helpers for split queries. Creating threads per query cost more
+// than the split saved on mid-sized lists, and every new thread started with an
+// empty thread_local QueryScratch: OR queries then zeroed a fresh totalDocs-sized
+// accumulator in each helper, every time. These threads keep theirs.
+class RangePool {
+private:
+    // One split query: the caller waits until all of its ranges are done
+    struct Batch {
+        const function<void(size_t)>* work;
+        size_t pending;
+        mutex lock;
+        condition_variable done;
+    };
+
+    BoundedQueue<pair<Batch*, size_t>> tasks;
+    vector<thread> workers;
+
+    static void finish(Batch& batch) {
+        lock_guard<mutex> guard(batch.lock);
+        if (--batch.pending == 0) batch.done.notify_one();
+    }
+
+public:
+    explicit RangePool(size_t helpers) : tasks(max(helpers, (size_t)1) * 4) {
+        for (size_t i = 0; i < helpers; ++i) {
+            workers.emplace_back([this] {
+                pair<Batch*, size_t> task;
+                while (tasks.pop(task)) {
+                    (*task.first->work)(task.second);
+                    finish(*task.first);
+                }
+            });
+        }
+    }
+    RangePool(const RangePool&) = delete;
+    RangePool& operator=(const RangePool&) = delete;
+
+    ~RangePool() {
+        tasks.close();
+        for (thread& t : workers) t.join();
+    }
+
+    // work(0) on the calling thread, work(1..parts-1) on the helpers.
+    // Helpers never submit, so concurrent callers can't deadlock each other.
+    void run(size_t parts, const function<void(size_t)>& work) {
+        Batch batch;
+        batch.work = &work;
+        batch.pending = parts;
+        for (size_t i = 1; i < parts; ++i) tasks.push({ &batch, i });
+        work(0);
+        finish(batch);
+        unique_lock<mutex> guard(batch.lock);
+        batch.done.wait(guard, [&] { return batch.pending == 0; });
+    }
+};
+
+// --- BARREL MANAGER ---
+// Maps every barrel_N.bin once (engine start / hot swap) and hands out
+// views straight into the mapping. No open(), seek() or copy per query.
+class BarrelManager {
+private:
+    vector<MappedFile> barrels;
+    vector<MappedFile> positionFiles; // barrel_N.pos (optional)
+    vector<bool> compressed; // true = v2 block format
+    vector<bool> boundsUsable; // true = block-max bounds match the engine's BM25 parameters
+    vector<bool> offsetsInLexicon; // true = lexicon.bin's inline offsets are this barrel's (see adoptLexiconOffsets)
+
+    // Offset of a list as this barrel's own table has it (0 = no postings)
+    uint64_t tableOffset(uint32_t barrelID, uint32_t localID) const {
+        const MappedFile& file = barrels[barrelID];
+        if (compressed[barrelID]) return blockListOffset(file.data(), file.size(), localID);
+        size_t slot = (size_t)localID * sizeof(long long);
+        if (slot + sizeof(long long) > file.size()) return 0;
+        long long dataOffset;
+        memcpy(&dataOffset, file.data() + slot, sizeof(dataOffset));
+        return dataOffset > 0 ? (uint64_t)dataOffset : 0;
+    }
+
+public:
+    // Opens barrel_0.bin ... barrel_K.bin covering 'totalWords' word IDs.
+    // Missing barrels stay unmapped and simply return empty spans.
+    size_t open(const string& dir, uint32_t totalWords) {
+        close();
+        uint32_t numBarrels = (totalWords + WORDS_PER_BARREL - 1) / WORDS_PER_BARREL;
+        barrels.resize(numBarrels);
+        positionFiles.resize(numBarrels);
+        compressed.assign(numBarrels, false);
+        boundsUsable.assign(numBarrels, false);
+        offsetsInLexicon.assign(numBarrels, false);
+
+        size_t opened = 0;
+        for (uint32_t b = 0; b < numBarrels; ++b) {
+            string fname = dir + "barrel_" + to_string(b) + ".bin";
+            if (!barrels[b].open(fname)) continue;
+
+            if (isBlockBarrel(barrels[b].data(), barrels[b].size())) {
+                BarrelHeader header = readBarrelHeader(barrels[b].data(), barrels[b].size());
+                if (header.version < BARREL_MIN_VERSION || header.version > BARREL_VERSION ||
+                    header.wordsPerBarrel != WORDS_PER_BARREL ||
+                    header.blockSize != POSTING_BLOCK_SIZE) {
+                    cerr << "Warning: " << fname << " has an unsupported barrel header. Skipped." << endl;
+                    barrels[b].close();
+                    continue;
+                }
+                compressed[b] = true;
+            }
+            openPositions(b, dir + "barrel_" + to_string(b) + ".pos");
+            opened++;
+        }
+        return opened;
+    }
+
+    void close() {
+        barrels.clear();
+        positionFiles.clear();
+        compressed.clear();
+        boundsUsable.clear();
+        offsetsInLexicon.clear();
+    }
+
+    // create_barrels writes every list's offset (and df) into lexicon.bin, so a
+    // term lookup can go straight to its list. That only holds for the barrels
+    // it wrote: a lexicon from another build or directory (hot swap, --from-v1
+    // elsewhere, a legacy lexicon) would point into the wrong bytes. So each
+    // barrel's table is compared with the lexicon once, at load (one pass over
+    // 8 bytes per word), and only matching barrels take offsets from it.
+    size_t adoptLexiconOffsets(const LexiconView& lexicon) {
+        size_t adopted = 0;
+        for (uint32_t b = 0; b < barrels.size(); ++b) {
+            offsetsInLexicon[b] = false;
+            if (!barrels[b].isOpen()) continue;
+            uint32_t first = b * WORDS_PER_BARREL;
+            uint32_t end = min((uint32_t)lexicon.size(), first + WORDS_PER_BARREL);
+            bool match = true;
+            for (uint32_t w = first; match && w < end; ++w) {
+                uint64_t inline_ = lexicon.listOffset(w);
+                uint64_t stored = tableOffset(b, w - first);
+                match = (inline_ == NO_LIST_OFFSET) ? (stored == 0 && lexicon.df(w) == 0)
+                                                    : (stored == inline_ && lexicon.df(w) > 0);
+            }
+            offsetsInLexicon[b] = match;
+            adopted += match ? 1 : 0;
+        }
+        return adopted;
+    }
+
+    // True if lexicon.bin says for sure that the word has no postings here
+    bool knownEmpty(uint32_t globalWordID, const LexiconView& lexicon) const {
+        uint32_t barrelID = globalWordID / WORDS_PER_BARREL;
+        return barrelID < offsetsInLexicon.size() && offsetsInLexicon[barrelID] && lexicon.df(globalWordID) == 0;
+    }
+
+    // Block-max bounds are only safe if they were computed with the same
+    // BM25 parameters and collection statistics the engine scores with.
+    // (e.g. --limit changes avgDL, which silently disables pruning.)
+    // Their maxPageRank must also come from the very static scores loaded:
+    // after a new page-rank run, or a fallback to pagerank_scores.txt, it may
+    // be below a doc's real prior and pruning would drop true top-k docs.
+    // v2 barrels don't record which scores they used, so they never prune.
+    size_t validateBounds(double avgDL, const StaticScores& staticScores) {
+        uint64_t fingerprint = staticScores.fingerprint();
+        size_t usable = 0;
+        for (size_t b = 0; b < barrels.size(); ++b) {
+            boundsUsable[b] = false;
+            if (!compressed[b]) continue;
+            BarrelHeader header = readBarrelHeader(barrels[b].data(), barrels[b].size());
+            if (!(header.flags & BARREL_FLAG_BLOCK_MAX)) continue;
+            if (header.k1 != (float)K1 || header.b != (float)B) continue;
+            if (avgDL <= 0 || fabs(header.avgDL - avgDL) > avgDL * 1e-6) continue;
+            if (header.version < 3 || header.staticDocs != staticScores.size() ||
+                header.staticFingerprint != fingerprint) continue;
+            boundsUsable[b] = true;
+            usable++;
+        }
+        return usable;
+    }
+
+    // Through the barrel's own offset table
+    PostingListRef postings(uint32_t globalWordID) const {
+        uint32_t barrelID = globalWordID / WORDS_PER_BARREL;
+        if (barrelID >= barrels.size() || !barrels[barrelID].isOpen()) return {};
+        return listAt(barrelID, tableOffset(barrelID, globalWordID % WORDS_PER_BARREL));
+    }
+
+    // 'inlineOffset': the word's listOffset from lexicon.bin, used instead of
+    // the offset table when the barrel was adopted (NO_LIST_OFFSET there = no
+    // postings, known without touching the barrel)
+    PostingListRef postings(uint32_t globalWordID, uint64_t inlineOffset) const {
+        uint32_t barrelID = globalWordID / WORDS_PER_BARREL;
+        if (barrelID >= barrels.size() || !barrels[barrelID].isOpen()) return {};
+        if (!offsetsInLexicon[barrelID]) return postings(globalWordID);
+        if (inlineOffset == NO_LIST_OFFSET) return {};
+        return listAt(barrelID, inlineOffset);
+    }
+
+    PostingListRef listAt(uint32_t barrelID, uint64_t offset) const {
+        const MappedFile& file = barrels[barrelID];
+        const uint8_t* base = file.data();
+        size_t fileSize = file.size();
+
+        PostingListRef ref;
+        if (compressed[barrelID]) {
+            ref.compressed = true;
+            ref.blocks = openBlockListAt(base, fileSize, offset);
+            if (!boundsUsable[barrelID]) ref.blocks.bounds = nullptr;
+            return ref;
+        }
+
+        // v1: [ListSize][Posting...] at the offset
+        if (offset == 0 || offset + sizeof(uint32_t) > fileSize) return {};
+        size_t dataOffset = (size_t)offset;
+
+        uint32_t listSize;
+        memcpy(&listSize, base + dataOffset, sizeof(listSize));
+        size_t listStart = dataOffset + sizeof(uint32_t);
+        if (listStart + (size_t)listSize * sizeof(Posting) > fileSize) return {}; // Truncated barrel
+
+        ref.raw = { (const Posting*)(base + listStart), listSize };
+        return ref;
+    }
+
+    // Positions of a word's postings, or an empty view if the barrel has none
+    // (or they don't belong to this barrel's list).
+    PositionListView positions(uint32_t globalWordID) const {
+        uint32_t barrelID = globalWordID / WORDS_PER_BARREL;
+        if (barrelID >= positionFiles.size() || !positionFiles[barrelID].isOpen()) return {};
+        const MappedFile& file = positionFiles[barrelID];
+        PositionListView view = openPositionList(file.data(), file.size(), globalWordID % WORDS_PER_BARREL);
+        if (view.count != postings(globalWordID).size()) return {};
+        return view;
+    }
+
+    size_t barrelCount() const { return barrels.size(); }
+
+    size_t positionalCount() const {
+        size_t n = 0;
+        for (const auto& f : positionFiles) n += f.isOpen() ? 1 : 0;
+        return n;
+    }
+
+    size_t compressedCount() const {
+        size_t n = 0;
+        for (bool c : compressed) n += c ? 1 : 0;
+        return n;
+    }
+
+    size_t mappedBytes() const {
+        size_t total = 0;
+        for (const auto& b : barrels) total += b.size();
+        for (const auto& f : positionFiles) total += f.size();
+        return total;
+    }
+
+    // Walks the page tables, so this is for diagnostics only (not per query)
+    size_t residentBytes() const {
+        size_t total = 0;
+        for (const auto& b : barrels) total += b.residentBytes();
+        for (const auto& f : positionFiles) total += f.residentBytes();
+        return total;
+    }
+
+private:
+    void openPositions(uint32_t b, const string& fname) {
+        if (!positionFiles[b].open(fname)) return;
+        const MappedFile& f = positionFiles[b];
+        PositionHeader header = {};
+        if (isPositionFile(f.data(), f.size())) memcpy(&header, f.data(), sizeof(header));
+        if (header.version != POSITION_VERSION || header.wordsPerBarrel != WORDS_PER_BARREL ||
+            header.blockSize != POSTING_BLOCK_SIZE) {
+            cerr << "Warning: " << fname << " is not a usable position file. Skipped." << endl;
+            positionFiles[b].close();
+        }
+    }
+};
+
+// Full paper details, copied out of the metadata store for printed docs only
 struct DocInfo {
     string originalID;
     string title;
@@ -51,48 +1086,81 @@ struct FlatNode {
 
 class BarrelSearcher {
 private:
-    unordered_map<string, int> lexicon;
+    LexiconView lexicon; // Mapped lexicon.bin (v2), looked up via its perfect hash
     vector<uint32_t> docLengths;
-    vector<double> pageRankScores;
-    vector<DocInfo> metadata;
+    vector<uint32_t> docDates; // Day numbers, NO_DATE if unknown
+    StaticScores staticScores;              // Mapped static_scores.bin (see static_score_format.h)
+    double priorFactor = PAGERANK_WEIGHT;   // value -> PAGERANK_WEIGHT * PageRank (1 if folded)
+    MetadataStore metadata;    // Mapped doc_metadata.bin (see metadata_format.h)
+    uint32_t metadataDocs = 0; // Docs with metadata, capped at DOC_LIMIT
     vector<FlatNode> trie; // NEW
+    BarrelManager barrels;
+
+    // Category postings: mapped categories.bin, or built from metadata if absent
+    MappedFile categoryFile;
+    vector<uint8_t> categoryImage;
+    vector<CategoryView> categories;
+    uint32_t categoryDocs = 0;
     
-    double avgDL;
-    uint32_t totalDocs;
+    double avgDL = 0;
+    uint32_t totalDocs = 0; // Stays 0 if doc_lengths.bin is missing
+    size_t mappedBarrels = 0;
+    uint64_t snapshotID = 0; // Set by LiveIndex: 1 = loaded at start, +1 per hot swap
+    PostingCache postingCache;    // Decoded hot lists (see POSTING CACHE)
+    ResultCache resultCache;      // Ranked results of recent queries (see RESULT CACHE)
+
+    // Scratch space is per thread: server workers run queries side by side
+    struct QueryScratch {
+        ScoreAccumulator accumulator;        // Reused by every OR query
+        vector<vector<uint32_t>> positions;  // Decoded positions, per query term
+        JsonWriter json;                     // Response buffer ("--json")
+    };
+    static QueryScratch& scratch() {
+        thread_local QueryScratch perThread;
+        return perThread;
+    }
+
+    size_t queryThreads = 1; // Workers one broad query may split across (see INTRA-QUERY PARALLELISM)
+    unique_ptr<RangePool> rangePool; // queryThreads - 1 helpers, started by setQueryThreads
 
     // --- CONFIGURATION ---
     bool JSON_MODE = false;
     uint32_t DOC_LIMIT = 0; // 0 = No Limit
+    bool EXHAUSTIVE = false; // true = never prune (for verifying the top-k path)
+    string barrelDir;        // Barrel directory this snapshot was loaded from
 
 public:
-    BarrelSearcher(bool jsonMode, uint32_t limit) : JSON_MODE(jsonMode), DOC_LIMIT(limit) { 
-        loadMetadata(); 
+    // Loads a complete index from 'dir' (barrels) and the shared files next to it.
+    // Load messages go to 'log' (unless jsonMode).
+    BarrelSearcher(bool jsonMode, uint32_t limit, bool exhaustive, const string& dir, ostream& log = cout)
+        : JSON_MODE(jsonMode), DOC_LIMIT(limit), EXHAUSTIVE(exhaustive), barrelDir(dir) { 
+        loadMetadata(log); 
     }
 
-    void loadMetadata() {
-        if (!JSON_MODE) cout << "--- Initializing Engine ---" << endl;
-        
-        lexicon.clear();
-        docLengths.clear();
-        pageRankScores.clear();
-        metadata.clear();
-        trie.clear(); // NEW
-
-        // 1. Lexicon (Standard)
-        ifstream lexFile(LEXICON_FILE, ios::binary);
-        if (lexFile) {
-            uint32_t totalWords;
-            lexFile.read((char*)&totalWords, sizeof(totalWords));
-            for (uint32_t i = 0; i < totalWords; i++) {
-                uint32_t len;
-                lexFile.read((char*)&len, sizeof(len));
-                string word(len, ' ');
-                lexFile.read(&word[0], len);
-                lexicon[word] = i;
-            }
-            lexFile.close();
+    BarrelSearcher(const BarrelSearcher&) = delete;
+    BarrelSearcher& operator=(const BarrelSearcher&) = delete;
+
+    // A hot swap only goes live if the new index can answer queries at all
+    bool usable() const { return lexicon.size() > 0 && totalDocs > 0 && mappedBarrels > 0; }
+    const string& directory() const { return barrelDir; }
+    void setSnapshotID(uint64_t id) { snapshotID = id; }
+
+    // Runs once per snapshot, on a fresh object: a hot swap loads a new one
+    void loadMetadata(ostream& log) {
+        if (!JSON_MODE) log << "--- Initializing Engine ---" << endl;
+
+        // 1. Lexicon (mapped; an old v1 file is converted in memory)
+        if (lexicon.open(LEXICON_FILE) && !JSON_MODE && lexicon.isLegacy()) {
+            log << "Note: lexicon.bin is in the old format; rerun build_lexicon for instant loads." << endl;
         }
 
+        // 1b. Barrels (mapped once, shared by every query)
+        mappedBarrels = barrels.open(barrelDir, (uint32_t)lexicon.size());
+        size_t inlineOffsets = barrels.adoptLexiconOffsets(lexicon);
+        if (!JSON_MODE) log << "Mapped " << mappedBarrels << "/" << barrels.barrelCount() << " barrels ("
+                            << barrels.mappedBytes() / (1024 * 1024) << " MB, list offsets from lexicon.bin for "
+                            << inlineOffsets << ")." << endl;
+
         // 2. Lengths (Standard)
         ifstream lenFile(LENGTHS_FILE, ios::binary);
         if (lenFile) {
@@ -111,259 +1179,1021 @@ public:
         for (uint32_t l : docLengths) sum += l;
         avgDL = (totalDocs > 0) ? (double)sum / totalDocs : 0;
 
-        // 3. Metadata (UPDATED)
-        if (!JSON_MODE) cout << "Loading Metadata...";
-        ifstream mFile(META_FILE);
-        if (mFile) {
-            string line;
-            while (getline(mFile, line)) {
-                if (DOC_LIMIT > 0 && metadata.size() >= DOC_LIMIT) break;
-
-                DocInfo doc;
-                stringstream ss(line);
-                string segment;
-                
-                // Parse "ID|Title|Authors|Category|Date"
-                getline(ss, doc.originalID, '|');
-                getline(ss, doc.title, '|');
-                getline(ss, doc.authors, '|');
-                getline(ss, doc.category, '|');
-                getline(ss, doc.date, '|');
-                
-                metadata.push_back(doc);
+        // 3. Metadata (mapped columns, fields decoded per printed doc)
+        if (!JSON_MODE) log << "Loading Metadata...";
+        loadMetadataStore(log);
+        if (!JSON_MODE && metadataDocs > 0) log << " Loaded " << metadataDocs << " docs." << endl;
+        loadCategories(log);
+        loadDates(log);
+
+        // 4. PageRank (static_scores.bin, or pagerank_scores.txt converted in memory)
+        priorFactor = PAGERANK_WEIGHT;
+        if (staticScores.load(STATIC_SCORES_FILE, PAGERANK_FILE, totalDocs)) {
+            priorFactor = PAGERANK_WEIGHT / staticScores.weight();
+            if (!JSON_MODE) {
+                log << "Static scores: " << staticScores.size() << " docs ("
+                    << (staticScores.encoding() == STATIC_QUANT16 ? "16-bit" : "float32")
+                    << (staticScores.weight() == (float)PAGERANK_WEIGHT ? ", prior folded" : "")
+                    << (staticScores.isMapped() ? ", mapped" : ", from pagerank_scores.txt") << ")." << endl;
+            }
+        }
+
+        // Bounds need avgDL and the static scores: checked once both are loaded
+        size_t prunable = barrels.validateBounds(avgDL, staticScores);
+        if (!JSON_MODE && barrels.compressedCount() > 0) {
+            log << "Block-max pruning: " << prunable << "/" << barrels.compressedCount() << " barrels." << endl;
+        }
+
+        // 5. Autocomplete Trie (NEW)
+        ifstream tFile(TRIE_FILE, ios::binary);
+        if (tFile) {
+            // Get size
+            tFile.seekg(0, ios::end);
+            size_t size = tFile.tellg();
+            tFile.seekg(0, ios::beg);
+            
+            size_t numNodes = size / sizeof(FlatNode);
+
+            trie.resize(numNodes);
+            tFile.read((char*)trie.data(), size);
+            if (!JSON_MODE) log << "Loaded Autocomplete Index (" << numNodes << " nodes)." << endl;
+        } else {
+            if (!JSON_MODE) log << "Warning: trie.bin not found. Autocomplete disabled." << endl;
+        }
+    }
+
+    // doc_metadata.bin must have been built from the doc_metadata.txt that is
+    // there now (add_document appends to it); otherwise it is built in memory.
+    void loadMetadataStore(ostream& log) {
+        uint64_t textBytes = metadataSourceBytes(META_FILE);
+        bool mapped = metadata.open(META_STORE_FILE);
+        if (mapped && (textBytes == 0 || metadata.sourceBytes() == textBytes)) {
+            if (!JSON_MODE) log << " (doc_metadata.bin, " << metadata.bytes() / (1024 * 1024) << " MB mapped)";
+        } else {
+            if (!JSON_MODE && mapped) log << " doc_metadata.bin is stale, rebuilding in memory...";
+            metadata.adopt(buildMetadataStore(META_FILE, DOC_LIMIT));
+        }
+        metadataDocs = metadata.size();
+        if (DOC_LIMIT > 0 && metadataDocs > DOC_LIMIT) metadataDocs = DOC_LIMIT;
+    }
+
+    DocInfo docInfo(uint32_t id) const {
+        DocInfo doc;
+        doc.originalID = metadata.field(id, META_ID);
+        doc.title = metadata.field(id, META_TITLE);
+        doc.authors = metadata.field(id, META_AUTHORS);
+        doc.category = metadata.field(id, META_CATEGORY);
+        doc.date = metadata.field(id, META_DATE);
+        return doc;
+    }
+
+    // categories.bin must cover every loaded doc; otherwise (missing or stale)
+    // the same sets are built from the metadata just loaded.
+    void loadCategories(ostream& log) {
+        string fname = barrelDir + "categories.bin";
+        if (categoryFile.open(fname)) {
+            if (readCategoryIndex(categoryFile.data(), categoryFile.size(), categoryDocs, categories) &&
+                categoryDocs >= metadataDocs) {
+                if (!JSON_MODE) log << "Category postings: " << categories.size() << " categories." << endl;
+                return;
+            }
+            if (!JSON_MODE) log << "Warning: " << fname << " does not match doc_metadata.txt. Rebuilding in memory." << endl;
+            categories.clear();
+            categoryFile.close();
+        }
+
+        vector<string> fields;
+        fields.reserve(metadataDocs);
+        for (uint32_t d = 0; d < metadataDocs; ++d) fields.push_back(metadata.field(d, META_CATEGORY));
+        categoryImage = buildCategoryIndex(fields);
+        readCategoryIndex(categoryImage.data(), categoryImage.size(), categoryDocs, categories);
+        if (!JSON_MODE) log << "Category postings: " << categories.size() << " categories (built at load)." << endl;
+    }
+
+    // doc_dates.bin (same layout as doc_lengths.bin). If it is missing or
+    // shorter than the loaded collection, the column comes from the metadata.
+    void loadDates(ostream& log) {
+        docDates.assign(totalDocs, NO_DATE);
+        ifstream dateFile(DATES_FILE, ios::binary);
+        uint32_t numDates = 0;
+        if (dateFile && dateFile.read((char*)&numDates, sizeof(numDates)) && numDates >= totalDocs) {
+            dateFile.read((char*)docDates.data(), totalDocs * sizeof(uint32_t));
+            if (dateFile) return;
+        }
+        if (!JSON_MODE) log << "Note: doc_dates.bin missing or stale. Date column built from metadata." << endl;
+        for (uint32_t d = 0; d < totalDocs && d < metadataDocs; ++d) docDates[d] = dayOrNone(metadata.field(d, META_DATE));
+    }
+
+    // "/cat:X" keeps docs with any category containing X (as the metadata
+    // substring match always did). One category is used in place; several
+    // are merged into a list or a bitmap, whichever is smaller.
+    void resolveCategory(const string& filter, DocFilter& out) const {
+        uint32_t limit = min(categoryDocs, metadataDocs);
+        vector<const CategoryView*> matches;
+        size_t total = 0;
+        bool allLists = true;
+        for (const CategoryView& c : categories) {
+            if (c.name.find(filter) == string::npos) continue;
+            matches.push_back(&c);
+            total += c.count;
+            allLists = allLists && c.kind == CATEGORY_LIST;
+        }
+
+        if (matches.empty()) {
+            out.setList(nullptr, 0, 0);
+        } else if (matches.size() == 1) {
+            const CategoryView& c = *matches[0];
+            if (c.kind == CATEGORY_LIST) out.setList(c.docs, c.count, limit);
+            else out.setBitmap(c.bits, limit);
+        } else if (allLists && chooseCategoryKind((uint32_t)min(total, (size_t)UINT32_MAX), categoryDocs) == CATEGORY_LIST) {
+            vector<uint32_t> docs;
+            docs.reserve(total);
+            for (const CategoryView* c : matches) docs.insert(docs.end(), c->docs, c->docs + c->count);
+            sort(docs.begin(), docs.end());
+            docs.erase(unique(docs.begin(), docs.end()), docs.end());
+            out.ownList(move(docs), limit);
+        } else {
+            vector<uint64_t> bits(bitmapWords(categoryDocs), 0);
+            for (const CategoryView* c : matches) {
+                if (c->kind == CATEGORY_BITMAP) {
+                    for (size_t w = 0; w < bits.size(); ++w) bits[w] |= c->bits[w];
+                } else {
+                    for (uint32_t i = 0; i < c->count; ++i) bits[c->docs[i] / 64] |= 1ULL << (c->docs[i] % 64);
+                }
             }
-            if (!JSON_MODE) cout << " Loaded " << metadata.size() << " docs." << endl;
+            out.ownBitmap(move(bits), limit);
         }
+    }
+
+    // --- JSON HELPERS ---
+    static string escapeJson(const string& s) {
+        string res;
+        appendJsonEscaped(res, s);
+        return res;
+    }
+
+    // Fields are read in place from the metadata store and escaped straight
+    // into the thread's reused buffer; the response goes out in one write.
+    void printJsonResults(const ResultPage& page, const QueryOptions& opts, long long searchTimeMs, ostream& out = cout) {
+        const QueryTimings& t = page.timings;
+        JsonWriter& json = scratch().json;
+        json.clear();
+        json.raw("{ \"time_ms\": ").number(searchTimeMs)
+            .raw(", \"tokenize_us\": ").number((long long)t.tokenize)
+            .raw(", \"fetch_us\": ").number((long long)t.fetch)
+            .raw(", \"intersect_us\": ").number((long long)t.intersect)
+            .raw(", \"score_us\": ").number((long long)t.score)
+            .raw(", \"sort_us\": ").number((long long)t.sort)
+            .raw(", \"offset\": ").number(opts.offset).raw(", \"limit\": ").number(opts.limit)
+            .raw(", \"has_more\": ").boolean(page.hasMore);
+        if (page.positionsMissing) json.raw(", \"positions_missing\": true");
+        json.raw(", \"results\": [");
+        bool first = true;
+        for (const Result& r : page.results) {
+            if (r.docID >= metadataDocs) continue;
+            json.raw(first ? "{" : ",{");
+            first = false;
+            json.raw("\"id\": ").quoted(metadata.view(r.docID, META_ID))
+                .raw(",\"title\": ").quoted(metadata.view(r.docID, META_TITLE))
+                .raw(",\"authors\": ").quoted(metadata.view(r.docID, META_AUTHORS))
+                .raw(",\"category\": ").quoted(metadata.view(r.docID, META_CATEGORY))
+                .raw(",\"date\": ").quoted(metadata.view(r.docID, META_DATE))
+                .raw(",\"score\": ").number(r.score)
+                .raw("}");
+        }
+        json.raw("] }\n");
+        json.writeTo(out);
+    }
+    
+    void printJsonSuggestions(const vector<string>& suggestions, ostream& out = cout) {
+        JsonWriter& json = scratch().json;
+        json.clear();
+        json.raw("{ \"suggestions\": [");
+        for (size_t i = 0; i < suggestions.size(); ++i) {
+            if (i > 0) json.raw(",");
+            json.quoted(suggestions[i]);
+        }
+        json.raw("] }\n");
+        json.writeTo(out);
+    }
+
+
+    void printJsonStats(ostream& out = cout) {
+        out << "{ \"snapshot\": " << snapshotID << ", \"index\": \"" << escapeJson(barrelDir) << "\""
+             << ", \"docs\": " << totalDocs
+             << ", \"barrels\": " << barrels.barrelCount()
+             << ", \"compressed_barrels\": " << barrels.compressedCount()
+             << ", \"positional_barrels\": " << barrels.positionalCount()
+             << ", \"categories\": " << categories.size()
+             << ", \"mapped_bytes\": " << barrels.mappedBytes()
+             << ", \"resident_bytes\": " << barrels.residentBytes()
+             << ", \"simd\": \"" << simdLevelName(activeSimdLevel()) << "\"";
+        PostingCacheStats cache = postingCache.stats();
+        out << ", \"posting_cache\": { \"budget_bytes\": " << cache.budgetBytes
+             << ", \"bytes\": " << cache.bytes << ", \"entries\": " << cache.entries
+             << ", \"hits\": " << cache.hits << ", \"misses\": " << cache.misses
+             << ", \"evictions\": " << cache.evictions << ", \"hit_rate\": " << cache.hitRate() << " }";
+        ResultCacheStats results = resultCache.stats();
+        out << ", \"result_cache\": { \"budget_bytes\": " << results.budgetBytes
+             << ", \"bytes\": " << results.bytes << ", \"entries\": " << results.entries
+             << ", \"hits\": " << results.hits << ", \"misses\": " << results.misses
+             << ", \"evictions\": " << results.evictions << ", \"hit_rate\": " << results.hitRate()
+             << ", \"generation\": " << results.generation << " } }" << endl;
+    }
+
+    void printStats(ostream& out = cout) {
+        out << "Snapshot: " << snapshotID << " (" << barrelDir << ", " << totalDocs << " docs)" << endl;
+        out << "Barrels: " << barrels.barrelCount() << " (" << barrels.compressedCount() << " v2, "
+             << barrels.positionalCount() << " with positions)"
+             << " | Categories: " << categories.size()
+             << " | Mapped: " << barrels.mappedBytes() / (1024 * 1024) << " MB"
+             << " | Resident: " << barrels.residentBytes() / (1024 * 1024) << " MB"
+             << " | SIMD: " << simdLevelName(activeSimdLevel()) << endl;
+        PostingCacheStats cache = postingCache.stats();
+        out << "Posting cache: " << cache.entries << " lists, " << cache.bytes / (1024 * 1024) << "/"
+             << cache.budgetBytes / (1024 * 1024) << " MB | Hits: " << cache.hits << " | Misses: " << cache.misses
+             << " | Evictions: " << cache.evictions << " | Hit rate: " << cache.hitRate() * 100 << "%" << endl;
+        ResultCacheStats results = resultCache.stats();
+        out << "Result cache: " << results.entries << " queries, " << results.bytes / 1024 << " KB"
+             << " | Hits: " << results.hits << " | Misses: " << results.misses
+             << " | Hit rate: " << results.hitRate() * 100 << "% | Generation: " << results.generation << endl;
+    }
+
+    void setPostingCacheBudget(size_t bytes) { postingCache.setBudget(bytes); }
+    void setQueryThreads(size_t threads) {
+        queryThreads = max(threads, (size_t)1);
+        rangePool.reset(queryThreads > 1 ? new RangePool(queryThreads - 1) : nullptr);
+    }
+    void configureResultCache(size_t bytes, long long ttlSeconds) { resultCache.configure(bytes, ttlSeconds); }
+
+    // Documents were added or changed outside a hot swap ("/flush")
+    uint64_t invalidateResults() { return resultCache.invalidate(); }
+
+    // --- BARREL FETCH (Memory Mapped) ---
+    // v1 lists are views into the mapping; v2 lists are decoded block by block on demand,
+    // or read from the posting cache once the term is hot. 'pin' keeps a cached list
+    // alive for as long as the caller holds it; callers without one (e.g. just
+    // sizing lists) bypass the cache and leave its statistics alone.
+    PostingListRef fetchPostings(int globalWordID, shared_ptr<const DecodedList>* pin = nullptr) {
+        PostingListRef ref = barrels.postings((uint32_t)globalWordID, lexicon.listOffset((uint32_t)globalWordID));
+        if (!ref.compressed || ref.blocks.numBlocks < CACHE_MIN_BLOCKS || pin == nullptr) return ref;
+
+        bool admit;
+        uint64_t gen;
+        shared_ptr<const DecodedList> list = postingCache.lookup((uint32_t)globalWordID, admit, gen);
+        if (!list && admit) {
+            auto fresh = make_shared<DecodedList>();
+            fresh->docs.resize((size_t)ref.blocks.numBlocks * POSTING_BLOCK_SIZE);
+            fresh->freqs.resize(fresh->docs.size());
+            for (uint32_t b = 0; b < ref.blocks.numBlocks; ++b) {
+                size_t start = (size_t)b * POSTING_BLOCK_SIZE;
+                ref.blocks.decodeBlock(b, fresh->docs.data() + start, fresh->freqs.data() + start);
+            }
+            fresh->docs.resize(ref.blocks.count);
+            fresh->freqs.resize(ref.blocks.count);
+            list = fresh;
+            postingCache.insert((uint32_t)globalWordID, list, gen);
+        }
+        if (list) {
+            ref.decoded = list.get();
+            *pin = move(list);
+        }
+        return ref;
+    }
+
+    // --- SCORING ---
+    // BM25 contribution of one term in one doc. Shared by every query path.
+    inline double termScore(double idf, uint32_t freq, uint32_t docID) const {
+        double tf = (double)freq;
+        double dl = (double)docLengths[docID];
+        
+        double num = tf * (K1 + 1);
+        double den = tf + K1 * (1 - B + B * (dl / avgDL));
+        
+        return idf * (num / den);
+    }
+
+    inline uint32_t docDate(uint32_t docID) const {
+        return (docID < docDates.size()) ? docDates[docID] : NO_DATE;
+    }
+
+    // Undated docs only pass when no range is asked for
+    inline bool passesDate(uint32_t docID, const QueryFilter& filter) const {
+        if (!filter.dated()) return true;
+        uint32_t day = docDate(docID);
+        return day != NO_DATE && day >= filter.since && day <= filter.until;
+    }
+
+    inline double staticScore(uint32_t docID) const {
+        return staticScores.value(docID) * priorFactor;
+    }
+
+    struct QueryTerm {
+        double idf;
+        PostingListRef ref;
+        string token;
+        int wordID;
+        shared_ptr<const DecodedList> pin; // Keeps ref.decoded alive (posting cache)
+    };
+
+    // Sorted, deduped query tokens: the word order of a query doesn't change its ranking
+    static vector<string> normalizeTokens(const string& q) {
+        vector<string> tokens = Tokenize::tokenize(q);
+        sort(tokens.begin(), tokens.end());
+        tokens.erase(unique(tokens.begin(), tokens.end()), tokens.end());
+        return tokens;
+    }
+
+    // Result cache key: everything that decides the ranking, nothing that
+    // only picks the page (offset/limit are served from the cached top-k)
+    static string resultKey(const string& q, const QueryOptions& opts) {
+        string key;
+        for (const string& token : normalizeTokens(q)) key += token + " ";
+        key += "|";
+        for (const auto& phrase : extractPhrases(q)) {
+            for (const string& token : phrase) key += token + " ";
+            key += "|";
+        }
+        key += "\ncat=" + opts.categoryFilter + "\ndays=" + to_string(opts.sinceDay) + "-" + to_string(opts.untilDay);
+        key += opts.sortByDate ? "\ndate" : "\nscore";
+        if (opts.disjunctive) key += "\nor";
+        if (opts.proximity) key += "\nnear";
+        return key;
+    }
+
+    // --- QUERY PREPARATION ---
+    // Tokenizes, resolves every term to its posting list and orders the terms
+    // shortest list first. Returns false if some term has no postings (AND fails);
+    // with requireAll off (OR) unknown terms are dropped instead.
+    bool prepareQuery(const string& q, vector<QueryTerm>& queryTerms, QueryTimings& timings, bool requireAll = true) {
+        queryTerms.clear();
+        StageClock clock;
+
+        // 1. Tokenize & Unique
+        vector<string> tokens = normalizeTokens(q);
+        timings.tokenize += clock.lap();
+        if (tokens.empty()) return false;
+
+        // 2. Resolve every term first: an unknown word, or one lexicon.bin's
+        //    inline df says has no postings, fails an AND query before any
+        //    barrel or cache is touched
+        vector<int> wordIDs;
+        wordIDs.reserve(tokens.size());
+        for (const string& token : tokens) {
+            int wordID = lexicon.find(token); // Read-only, so workers share it freely
+            if (wordID == -1 || barrels.knownEmpty((uint32_t)wordID, lexicon)) {
+                if (!requireAll) wordID = -1;
+                else {
+                    timings.tokenize += clock.lap();
+                    return false; // Short-circuit: AND logic requires all terms
+                }
+            }
+            wordIDs.push_back(wordID);
+        }
+        timings.tokenize += clock.lap();
+
+        // 3. Locate All Posting Lists & Calculate IDFs (nothing is decoded yet)
+        queryTerms.reserve(tokens.size());
+
+        for (size_t t = 0; t < tokens.size(); ++t) {
+            const string& token = tokens[t];
+            int wordID = wordIDs[t];
+            if (wordID == -1) continue; // OR: dropped
+
+            shared_ptr<const DecodedList> pin;
+            PostingListRef ref = fetchPostings(wordID, &pin);
+            timings.fetch += clock.lap();
+            if (ref.empty()) {
+                if (!requireAll) continue;
+                return false; // Safety check
+            }
+
+            double n = (double)ref.size();
+            double idf = log((totalDocs - n + 0.5) / (n + 0.5) + 1.0);
+            
+            queryTerms.push_back({idf, ref, token, wordID, move(pin)});
+        }
+
+        // 4. Optimization: Sort by List Size (Shortest First)
+        // This minimizes the initial candidate set and speeds up intersection.
+        sort(queryTerms.begin(), queryTerms.end(), [](const QueryTerm& a, const QueryTerm& b) {
+            return a.ref.size() < b.ref.size();
+        });
+        return !queryTerms.empty();
+    }
+
+    // --- PHRASES & PROXIMITY ---
+    // "quoted text" in the query = phrase; tokenized like the documents were.
+    static vector<vector<string>> extractPhrases(const string& q) {
+        vector<vector<string>> phrases;
+        size_t open = q.find('"');
+        while (open != string::npos) {
+            size_t close = q.find('"', open + 1);
+            string text = q.substr(open + 1, (close == string::npos) ? string::npos : close - open - 1);
+            vector<string> tokens = Tokenize::tokenize(text);
+            if (tokens.size() > 1) phrases.push_back(tokens); // A single word is no constraint
+            if (close == string::npos) break;
+            open = q.find('"', close + 1);
+        }
+        return phrases;
+    }
+
+    // Resolves phrases to term indices and opens the position lists they need.
+    // Returns false (plan left inactive) if some needed list has no positions.
+    bool planPositions(const string& q, const vector<QueryTerm>& queryTerms, bool proximity, PositionalPlan& plan) {
+        for (const auto& tokens : extractPhrases(q)) {
+            vector<PhraseTerm> phrase;
+            for (uint32_t offset = 0; offset < tokens.size(); ++offset) {
+                for (uint32_t t = 0; t < queryTerms.size(); ++t) {
+                    if (queryTerms[t].token == tokens[offset]) phrase.push_back({t, offset});
+                }
+            }
+            plan.phrases.push_back(phrase);
+        }
+        plan.proximity = (proximity || !plan.phrases.empty()) && queryTerms.size() > 1;
+        if (!plan.active()) return true;
+
+        vector<bool> needed(queryTerms.size(), plan.proximity);
+        for (const auto& phrase : plan.phrases) {
+            for (const auto& pt : phrase) needed[pt.term] = true;
+        }
+
+        plan.lists.resize(queryTerms.size());
+        for (uint32_t t = 0; t < queryTerms.size(); ++t) {
+            if (!needed[t]) continue;
+            plan.lists[t] = barrels.positions((uint32_t)queryTerms[t].wordID);
+            if (plan.lists[t].empty()) {
+                plan = PositionalPlan(); // Fall back to a plain AND query
+                return false;
+            }
+            plan.decode.push_back(t);
+        }
+        return true;
+    }
+
+    // Called once every cursor sits on the same doc. Decodes only that doc's
+    // positions; false if a phrase doesn't occur. 'boost' gets the proximity bonus.
+    bool matchPositions(const PositionalPlan& plan, const vector<PostingCursor>& cursors, double& boost) {
+        vector<vector<uint32_t>>& positions = scratch().positions; // This thread's
+        if (positions.size() < cursors.size()) positions.resize(cursors.size());
+        for (uint32_t t : plan.decode) {
+            const PostingCursor& c = cursors[t];
+            vector<uint32_t>& out = positions[t];
+            out.resize(c.freq());
+            out.resize(plan.lists[t].decode(c.ordinal(), c.positionsBefore(), c.freq(), out.data()));
+        }
+
+        for (const auto& phrase : plan.phrases) {
+            if (!phraseOccurs(phrase, positions)) return false;
+        }
+
+        if (plan.proximity) {
+            uint32_t span = minimalSpan(plan.decode, positions);
+            if (span > 0) boost = PROXIMITY_WEIGHT * (double)(plan.decode.size() - 1) / span;
+        }
+        return true;
+    }
+
+    // Some start p with every phrase term at p + offset
+    static bool phraseOccurs(const vector<PhraseTerm>& phrase, const vector<vector<uint32_t>>& positions) {
+        if (phrase.empty()) return true;
+        const PhraseTerm& first = phrase[0];
+        for (uint32_t p : positions[first.term]) {
+            if (p < first.offset) continue;
+            uint32_t start = p - first.offset;
+            bool all = true;
+            for (size_t i = 1; i < phrase.size() && all; ++i) {
+                const vector<uint32_t>& pos = positions[phrase[i].term];
+                all = binary_search(pos.begin(), pos.end(), start + phrase[i].offset);
+            }
+            if (all) return true;
+        }
+        return false;
+    }
+
+    // Smallest (last - first) position of a window holding every listed term; 0 if none
+    static uint32_t minimalSpan(const vector<uint32_t>& terms, const vector<vector<uint32_t>>& positions) {
+        vector<size_t> at(terms.size(), 0);
+        uint32_t best = 0;
+        while (true) {
+            uint32_t lo = UINT32_MAX, hi = 0;
+            size_t loTerm = 0;
+            for (size_t i = 0; i < terms.size(); ++i) {
+                const vector<uint32_t>& pos = positions[terms[i]];
+                if (at[i] >= pos.size()) return best;
+                if (pos[at[i]] < lo) { lo = pos[at[i]]; loTerm = i; }
+                hi = max(hi, pos[at[i]]);
+            }
+            uint32_t span = hi - lo;
+            if (span > 0 && (best == 0 || span < best)) best = span;
+            at[loTerm]++;
+        }
+    }
+
+    // --- OPTIMIZED QUERY FUNCTION ---
+    // Only the first offset+limit results can ever be shown; one extra tells
+    // us whether a next page exists. Repeated queries are answered from the
+    // result cache (verification runs with /exhaustive always recompute).
+    ResultPage query(const string& q, const QueryOptions& opts) {
+        size_t k = opts.offset + opts.limit + 1;
+        bool cacheable = !opts.exhaustive && !EXHAUSTIVE;
+
+        string key;
+        uint64_t gen = 0;
+        shared_ptr<const CachedResults> results;
+        if (cacheable) {
+            key = resultKey(q, opts);
+            results = resultCache.lookup(key, k, gen);
+        }
+        ResultPage page;
+        if (!results) {
+            auto fresh = make_shared<CachedResults>();
+            fresh->top = rankTopK(q, opts, k, fresh->positionsMissing, page.timings);
+            fresh->complete = fresh->top.size() < k;
+            if (cacheable) resultCache.insert(key, fresh, gen);
+            results = fresh;
+        }
+
+        StageClock clock;
+        const vector<Result>& top = results->top;
+        page.positionsMissing = results->positionsMissing;
+        page.hasMore = top.size() > opts.offset + opts.limit;
+        if (top.size() > opts.offset) {
+            size_t end = min(top.size(), opts.offset + opts.limit);
+            page.results.assign(top.begin() + opts.offset, top.begin() + end);
+        }
+        page.timings.sort += clock.lap();
+        return page;
+    }
+
+    // Best k results, best first
+    vector<Result> rankTopK(const string& q, const QueryOptions& opts, size_t k, bool& positionsMissing,
+                            QueryTimings& timings) {
+        vector<QueryTerm> queryTerms;
+        if (!prepareQuery(q, queryTerms, timings, !opts.disjunctive)) return {};
+        StageClock clock;
+
+        // Phrases / proximity need positions (AND only: OR has no per-doc cursors)
+        PositionalPlan plan;
+        if (!opts.disjunctive && !planPositions(q, queryTerms, opts.proximity, plan)) {
+            positionsMissing = true;
+        }
+
+        // Filters: the category becomes a docID set that joins the intersection,
+        // the date range is checked against the date column per candidate
+        DocFilter categorySet;
+        QueryFilter filter;
+        filter.since = opts.sinceDay;
+        filter.until = opts.untilDay;
+        if (filter.since > filter.until) return {}; // Empty range
+        if (!opts.categoryFilter.empty()) {
+            resolveCategory(opts.categoryFilter, categorySet);
+            if (categorySet.empty()) return {}; // No such category
+            filter.category = &categorySet;
+        }
+
+        // Dynamic Pruning (Block-Max) when ranking by score
+        bool prunable = !opts.sortByDate && !opts.exhaustive && !opts.disjunctive && !EXHAUSTIVE;
+        for (const auto& term : queryTerms) {
+            if (!term.ref.compressed || term.ref.blocks.bounds == nullptr) prunable = false;
+        }
+
+        auto evaluate = [&](const QueryFilter& part, QueryTimings& spent) {
+            if (prunable) return queryTopK(queryTerms, part, plan, k, spent);
+            if (opts.sortByDate) return selectByDate(queryTerms, opts, part, plan, k, spent);
+            return selectTopK(queryTerms, opts, part, plan, k, rankedBefore, spent);
+        };
+
+        vector<uint32_t> bounds = splitPoints(queryTerms, opts.disjunctive);
+        timings.fetch += clock.lap();
+        if (bounds.size() <= 2) return evaluate(filter, timings);
 
-        // 4. PageRank (Standard)
-        pageRankScores.resize(totalDocs, 0.0);
-        ifstream prFile(PAGERANK_FILE);
-        if (prFile) {
-            int id; double score;
-            while(prFile >> id >> score) {
-                if(id < (int)totalDocs) pageRankScores[id] = score;
+        // Broad query: one docID range per worker, each into its own top-k
+        size_t parts = bounds.size() - 1;
+        vector<vector<Result>> partial(parts);
+        vector<QueryTimings> partTimings(parts);
+        function<void(size_t)> work = [&](size_t i) {
+            DocFilter categoryView;
+            QueryFilter part = filter;
+            if (filter.category) {
+                categoryView.viewOf(*filter.category);
+                part.category = &categoryView;
             }
-        }
-
-        // 5. Autocomplete Trie (NEW)
-        ifstream tFile(TRIE_FILE, ios::binary);
-        if (tFile) {
-            // Get size
-            tFile.seekg(0, ios::end);
-            size_t size = tFile.tellg();
-            tFile.seekg(0, ios::beg);
-            
-            size_t numNodes = size / sizeof(FlatNode);
+            part.firstDoc = bounds[i];
+            part.endDoc = bounds[i + 1];
+            partial[i] = evaluate(part, partTimings[i]);
+        };
+        rangePool->run(parts, work);
+        for (const QueryTimings& spent : partTimings) timings.takeSlowest(spent);
+        clock.lap();
 
-            trie.resize(numNodes);
-            tFile.read((char*)trie.data(), size);
-            if (!JSON_MODE) cout << "Loaded Autocomplete Index (" << numNodes << " nodes)." << endl;
+        // Merge: the same total order as the serial path, so the same answer
+        auto newer = [this](const Result& a, const Result& b) { return dateRankedBefore(a, b); };
+        vector<Result> top;
+        if (opts.sortByDate) {
+            TopK<decltype(newer)> merged(k, newer);
+            for (const auto& results : partial) for (const Result& r : results) merged.push(r);
+            top = merged.take();
         } else {
-            if (!JSON_MODE) cout << "Warning: trie.bin not found. Autocomplete disabled." << endl;
+            TopK<bool(*)(const Result&, const Result&)> merged(k, rankedBefore);
+            for (const auto& results : partial) for (const Result& r : results) merged.push(r);
+            top = merged.take();
         }
+        timings.sort += clock.lap();
+        return top;
     }
 
-    // --- JSON HELPERS ---
-    string escapeJson(const string& s) {
-        string res = "";
-        for (char c : s) {
-            if (c == '"') res += "\\\"";
-            else if (c == '\\') res += "\\\\";
-            else if (c == '\b') res += "\\b";
-            else if (c == '\f') res += "\\f";
-            else if (c == '\n') res += "\\n";
-            else if (c == '\r') res += "\\r";
-            else if (c == '\t') res += "\\t";
-            else res += c;
+    // --- INTRA-QUERY PARALLELISM ---
+    // A broad query's docID space is cut into ranges that are intersected and
+    // scored on separate threads. Cost = postings the evaluator will walk: the
+    // lead list once per term for AND (every lead doc probes the others), all
+    // lists for OR. Below PARALLEL_MIN_COST per extra thread, handing off costs
+    // more than it saves. Range starts are lastDocID + 1 of blocks in the
+    // basis list's skip directory (v1: a posting at that index), so a worker
+    // reaches its start with one skip search and the parts hold equal numbers
+    // of basis postings. Returns [0, b1, ..., END]; two entries = don't split.
+    vector<uint32_t> splitPoints(const vector<QueryTerm>& queryTerms, bool disjunctive) const {
+        uint32_t end = PostingCursor::END;
+        vector<uint32_t> bounds = { 0, end };
+        if (queryThreads <= 1 || queryTerms.empty()) return bounds;
+
+        const PostingListRef* basis = &queryTerms[0].ref; // AND: the shortest list leads
+        size_t cost = 0;
+        for (const auto& term : queryTerms) {
+            if (disjunctive && term.ref.size() > basis->size()) basis = &term.ref;
+            cost += disjunctive ? term.ref.size() : queryTerms[0].ref.size();
         }
-        return res;
+        size_t parts = min(queryThreads, cost / PARALLEL_MIN_COST);
+        uint32_t units = basis->compressed ? basis->blocks.numBlocks : basis->raw.count;
+        parts = min(parts, (size_t)units);
+        if (parts <= 1) return bounds;
+
+        bounds.pop_back();
+        for (size_t i = 1; i < parts; ++i) {
+            uint32_t unit = (uint32_t)(i * units / parts);
+            uint32_t start = basis->compressed ? basis->blocks.dir[unit - 1].lastDocID + 1 : basis->raw[unit].docID;
+            if (start > bounds.back()) bounds.push_back(start);
+        }
+        bounds.push_back(end);
+        return bounds;
     }
 
-    void printJsonResults(const vector<Result>& results, long long searchTimeMs) {
-        cout << "{ \"time_ms\": " << searchTimeMs << ", \"results\": [";
-        for (size_t i = 0; i < results.size(); ++i) {
-            uint32_t id = results[i].docID;
-            if (id >= metadata.size()) continue;
+    // Newest first (undated last); same-day docs fall back to the score ranking
+    bool dateRankedBefore(const Result& a, const Result& b) const {
+        uint32_t dayA = docDate(a.docID), dayB = docDate(b.docID);
+        if (dayA != dayB) return dayA > dayB;
+        return rankedBefore(a, b);
+    }
 
-            const DocInfo& doc = metadata[id];
-            cout << "{";
-            cout << "\"id\": \"" << escapeJson(doc.originalID) << "\",";
-            cout << "\"title\": \"" << escapeJson(doc.title) << "\",";
-            cout << "\"authors\": \"" << escapeJson(doc.authors) << "\",";
-            cout << "\"category\": \"" << escapeJson(doc.category) << "\",";
-            cout << "\"date\": \"" << escapeJson(doc.date) << "\",";
-            cout << "\"score\": " << results[i].score;
-            cout << "}";
-            if (i < results.size() - 1) cout << ",";
-        }
-        cout << "] }" << endl;
+    // Top-k by date. Once k results are held, a doc older than the k-th can
+    // never get in, so the range's lower end is raised to the k-th's day and
+    // older docs are dropped during the intersection, before scoring.
+    vector<Result> selectByDate(const vector<QueryTerm>& queryTerms, const QueryOptions& opts,
+                                const QueryFilter& filter, const PositionalPlan& plan, size_t k, QueryTimings& timings) {
+        auto newer = [this](const Result& a, const Result& b) { return dateRankedBefore(a, b); };
+        TopK<decltype(newer)> top(k, newer);
+        QueryFilter floor = filter;
+        auto emit = [&](const Result& r) {
+            top.push(r);
+            if (top.full()) floor.since = max(floor.since, docDate(top.worst().docID));
+        };
+        evaluateTimed(queryTerms, opts.disjunctive, floor, plan, timings, emit);
+        return takeTimed(top, timings);
     }
-    
-    void printJsonSuggestions(const vector<string>& suggestions) {
-        cout << "{ \"suggestions\": [";
-        for (size_t i = 0; i < suggestions.size(); ++i) {
-            cout << "\"" << escapeJson(suggestions[i]) << "\"";
-            if (i < suggestions.size() - 1) cout << ",";
+
+    // Exhaustive evaluation straight into a bounded heap
+    template<typename Better>
+    vector<Result> selectTopK(const vector<QueryTerm>& queryTerms, const QueryOptions& opts, const QueryFilter& filter,
+                              const PositionalPlan& plan, size_t k, Better better, QueryTimings& timings) {
+        TopK<Better> top(k, better);
+        auto emit = [&](const Result& r) { top.push(r); };
+        evaluateTimed(queryTerms, opts.disjunctive, filter, plan, timings, emit);
+        return takeTimed(top, timings);
+    }
+
+    // AND walks the lists with BM25 inline (all 'intersect'); OR charges its two passes itself
+    template<typename Sink>
+    void evaluateTimed(const vector<QueryTerm>& queryTerms, bool disjunctive, const QueryFilter& filter,
+                       const PositionalPlan& plan, QueryTimings& timings, Sink&& emit) {
+        if (disjunctive) {
+            evaluateTAAT(queryTerms, filter, timings, emit);
+            return;
         }
-        cout << "] }" << endl;
+        StageClock clock;
+        evaluateDAAT(queryTerms, filter, plan, emit);
+        timings.intersect += clock.lap();
     }
 
+    template<typename Better>
+    static vector<Result> takeTimed(TopK<Better>& top, QueryTimings& timings) {
+        StageClock clock;
+        vector<Result> results = top.take();
+        timings.sort += clock.lap();
+        return results;
+    }
 
-    // --- BARREL FETCH (Standard) ---
-    vector<Posting> fetchPostings(int globalWordID) {
-        int barrelID = globalWordID / WORDS_PER_BARREL;
-        int localID = globalWordID % WORDS_PER_BARREL;
-        string fname = BARREL_DIR + "barrel_" + to_string(barrelID) + ".bin";
-        ifstream file(fname, ios::binary);
-        if (!file) return {}; 
+    // --- TERM-AT-A-TIME EVALUATION (OR) ---
+    // Each list is streamed once, front to back, adding its BM25 share into
+    // the accumulator; docs matching more terms simply collect more. A filter
+    // is walked alongside each list, so filtered-out docs are never scored.
+    // Then the static score is added once per candidate doc.
+    template<typename Sink>
+    void evaluateTAAT(const vector<QueryTerm>& queryTerms, const QueryFilter& filter, QueryTimings& timings, Sink&& emit) {
+        StageClock clock;
+        size_t totalPostings = 0;
+        for (const auto& term : queryTerms) totalPostings += term.ref.size();
+        ScoreAccumulator& accumulator = scratch().accumulator;
+        accumulator.begin(totalDocs, totalPostings);
 
-        long long offsetPos = localID * sizeof(long long);
-        file.seekg(offsetPos);
-        long long dataOffset;
-        file.read((char*)&dataOffset, sizeof(dataOffset));
-        if (dataOffset == 0) return {}; 
+        PostingCursor cursor;
+        for (const auto& term : queryTerms) {
+            cursor.reset(&term.ref);
+            if (filter.category) filter.category->rewind();
+            uint32_t docID = cursor.nextGEQ(filter.firstDoc);
+            while (docID != PostingCursor::END) {
+                if (docID >= totalDocs || docID >= filter.endDoc) break; // Lists are sorted: the rest is out of range too
+                if (filter.category) {
+                    uint32_t allowed = filter.category->nextGEQ(docID);
+                    if (allowed == DocFilter::END) break;
+                    if (allowed != docID) { docID = cursor.nextGEQ(allowed); continue; }
+                }
+                if (!passesDate(docID, filter)) { docID = cursor.next(); continue; }
+                accumulator.add(docID, termScore(term.idf, cursor.freq(), docID));
+                docID = cursor.next();
+            }
+        }
 
-        file.seekg(dataOffset);
-        uint32_t listSize;
-        file.read((char*)&listSize, sizeof(listSize));
-        vector<Posting> results(listSize);
-        file.read((char*)results.data(), listSize * sizeof(Posting));
-        return results;
+        timings.intersect += clock.lap();
+
+        accumulator.drain([&](const Result& r) { emit(Result{r.docID, r.score + staticScore(r.docID)}); });
+        timings.score += clock.lap();
     }
 
-    // --- OPTIMIZED QUERY FUNCTION (VECTOR INTERSECTION) ---
-    vector<Result> query(string q, string categoryFilter = "", bool sortByDate = false) {
-        
-        // 1. Tokenize & Unique
-        vector<string> rawTokens = Tokenize::tokenize(q);
-        if (rawTokens.empty()) return {};
+    // --- DOCUMENT-AT-A-TIME EVALUATION ---
+    // One cursor per term. The shortest list leads; every other cursor leaps
+    // forward (galloping / skip pointers) to the lead's doc. When all agree,
+    // the cursors already sit on that doc's postings, so BM25 is accumulated
+    // right there: each posting is touched at most once, no re-searching.
+    // Filters are checked first: the category as the cheapest list to leap
+    // with, then the date column. Every match is handed to 'emit'.
+    template<typename Sink>
+    void evaluateDAAT(const vector<QueryTerm>& queryTerms, const QueryFilter& filter,
+                      const PositionalPlan& plan, Sink&& emit) {
+        vector<PostingCursor> cursors(queryTerms.size());
+        for (size_t i = 0; i < queryTerms.size(); ++i) cursors[i].reset(&queryTerms[i].ref);
 
-        vector<string> tokens;
-        sort(rawTokens.begin(), rawTokens.end());
-        unique_copy(rawTokens.begin(), rawTokens.end(), back_inserter(tokens));
+        uint32_t docID = cursors[0].nextGEQ(filter.firstDoc);
+        while (docID < filter.endDoc) { // END included
+            if (filter.category) {
+                uint32_t allowed = filter.category->nextGEQ(docID);
+                if (allowed == DocFilter::END) break;
+                if (allowed != docID) { docID = cursors[0].nextGEQ(allowed); continue; }
+            }
+            if (!passesDate(docID, filter)) { docID = cursors[0].next(); continue; }
 
-        // 2. Fetch All Posting Lists & Calculate IDFs
-        struct QueryTerm {
-            double idf;
-            vector<Posting> postings;
-        };
-        
-        vector<QueryTerm> queryTerms;
-        queryTerms.reserve(tokens.size());
+            uint32_t next = docID;
+            for (size_t i = 1; i < cursors.size(); ++i) {
+                next = cursors[i].nextGEQ(docID);
+                if (next != docID) break;
+            }
+            if (next == PostingCursor::END) break;
 
-        for (const string& token : tokens) {
-            if (lexicon.find(token) == lexicon.end()) {
-                return {}; // Short-circuit: AND logic requires all terms
+            if (next != docID) {
+                // Some list doesn't have docID: leap the lead to that list's next doc
+                docID = cursors[0].nextGEQ(next);
+                continue;
             }
-            
-            vector<Posting> p = fetchPostings(lexicon[token]);
-            if (p.empty()) return {}; // Safety check
 
-            double n = (double)p.size();
-            double idf = log((totalDocs - n + 0.5) / (n + 0.5) + 1.0);
-            
-            queryTerms.push_back({idf, move(p)});
+            double boost = 0.0;
+            if (!plan.active() || matchPositions(plan, cursors, boost)) {
+                double docScore = boost;
+                for (size_t i = 0; i < cursors.size(); ++i) {
+                    docScore += termScore(queryTerms[i].idf, cursors[i].freq(), docID);
+                }
+                docScore += staticScore(docID);
+                emit(Result{docID, docScore});
+            }
+            docID = cursors[0].next();
         }
+    }
 
-        // 3. Optimization: Sort by List Size (Shortest First)
-        // This minimizes the initial candidate set and speeds up intersection.
-        sort(queryTerms.begin(), queryTerms.end(), [](const QueryTerm& a, const QueryTerm& b) {
-            return a.postings.size() < b.postings.size();
-        });
-
-        // 4. Vector Intersection (The Core Optimization)
-        // Initialize candidates with the shortest list's docIDs
+    // --- TWO-PHASE EVALUATION (Reference) ---
+    // Intersect all lists first, then go back and look up each survivor's
+    // freq in every list. Kept to benchmark against evaluateDAAT (--bench).
+    vector<Result> evaluateTwoPhase(const vector<QueryTerm>& queryTerms, const QueryFilter& filter) {
+        // 1. Initialize candidates with the shortest list's docIDs
         vector<uint32_t> candidates;
-        candidates.reserve(queryTerms[0].postings.size());
-        for (const auto& p : queryTerms[0].postings) candidates.push_back(p.docID);
+        appendDocIDs(queryTerms[0].ref, candidates);
 
-        // Intersect with remaining lists
+        // 2. Intersect with remaining lists (shortest first, so candidates only shrink)
+        PostingCursor skipCursor;
         for (size_t i = 1; i < queryTerms.size(); ++i) {
             if (candidates.empty()) break; // No matches possible
 
-            vector<uint32_t> nextCandidates;
-            nextCandidates.reserve(candidates.size()); // Heuristic: can't grow
-
-            const vector<Posting>& currentList = queryTerms[i].postings;
-            
-            // Two-Pointer Intersection (works because both are sorted by docID)
-            size_t p1 = 0;
-            size_t p2 = 0;
-            
-            while (p1 < candidates.size() && p2 < currentList.size()) {
-                if (candidates[p1] < currentList[p2].docID) {
-                    p1++;
-                } else if (candidates[p1] > currentList[p2].docID) {
-                    p2++;
-                } else {
-                    // Match found!
-                    nextCandidates.push_back(candidates[p1]);
-                    p1++;
-                    p2++;
+            const PostingListRef& ref = queryTerms[i].ref;
+            size_t kept = 0;
+            if (ref.compressed) {
+                // Skip pointers: blocks that can't hold a candidate are never decoded
+                skipCursor.reset(&ref);
+                for (uint32_t docID : candidates) {
+                    uint32_t found = skipCursor.nextGEQ(docID);
+                    if (found == PostingCursor::END) break;
+                    if (found == docID) candidates[kept++] = docID;
                 }
+            } else {
+                // Galloping or SIMD block compare, depending on the size ratio
+                // (only here: the DAAT cursors gallop and call findGEQ instead)
+                kept = intersectAdaptive<2>(candidates.data(), candidates.size(),
+                                            (const uint32_t*)ref.raw.ptr, ref.raw.count, candidates.data());
             }
-            candidates = nextCandidates;
+            candidates.resize(kept);
         }
 
-        if (candidates.empty()) return {};
-
-        // 5. Scoring (Only for Survivors)
+        // 3. Scoring (Only for Survivors)
         vector<Result> finalRes;
         finalRes.reserve(candidates.size());
 
+        // Candidates are sorted, so v2 lists are read with forward-only cursors
+        vector<PostingCursor> cursors(queryTerms.size());
+        for (size_t i = 0; i < queryTerms.size(); ++i) cursors[i].reset(&queryTerms[i].ref);
+
         for (uint32_t docID : candidates) {
+            // Filters
+            if (filter.category && !filter.category->contains(docID)) continue;
+            if (!passesDate(docID, filter)) continue;
+
             double docScore = 0.0;
             
             // Calculate score for each term
-            for (const auto& term : queryTerms) {
-                // Find freq of this term in this doc
-                // Since we need random access now, we use binary search (lower_bound)
-                // Note: Linear scan might be faster if k is small, but lower_bound is robust.
-                
-                auto it = lower_bound(term.postings.begin(), term.postings.end(), docID, 
-                    [](const Posting& p, uint32_t id) { return p.docID < id; });
-                
-                if (it != term.postings.end() && it->docID == docID) {
-                    double tf = (double)it->freq;
-                    double dl = (double)docLengths[docID];
-                    
-                    double num = tf * (K1 + 1);
-                    double den = tf + K1 * (1 - B + B * (dl / avgDL));
-                    
-                    docScore += term.idf * (num / den);
+            for (size_t i = 0; i < queryTerms.size(); ++i) {
+                const QueryTerm& term = queryTerms[i];
+                if (term.ref.compressed) {
+                    if (cursors[i].nextGEQ(docID) == docID) {
+                        docScore += termScore(term.idf, cursors[i].freq(), docID);
+                    }
+                    continue;
                 }
-            }
 
-            // Category Filter
-            if (!categoryFilter.empty()) {
-                if (docID >= metadata.size() || metadata[docID].category.find(categoryFilter) == string::npos) {
-                    continue; 
+                // Find freq of this term in this doc (binary search over the whole list)
+                auto it = lower_bound(term.ref.raw.begin(), term.ref.raw.end(), docID, 
+                    [](const Posting& p, uint32_t id) { return p.docID < id; });
+                
+                if (it != term.ref.raw.end() && it->docID == docID) {
+                    docScore += termScore(term.idf, it->freq, docID);
                 }
             }
 
             // Final Ranking Score
-            if (docID < pageRankScores.size()) {
-                 docScore += (pageRankScores[docID] * PAGERANK_WEIGHT);
-            }
+            docScore += staticScore(docID);
             
             finalRes.push_back({docID, docScore});
         }
+        return finalRes;
+    }
 
-        // 6. Sort Results
-        if (sortByDate) {
-            sort(finalRes.begin(), finalRes.end(), [&](const Result& a, const Result& b) {
-                string dateA = (a.docID < metadata.size()) ? metadata[a.docID].date : "0000";
-                string dateB = (b.docID < metadata.size()) ? metadata[b.docID].date : "0000";
-                return dateA > dateB; 
-            });
-        } else {
-            sort(finalRes.begin(), finalRes.end(), [](const Result& a, const Result& b){
-                return a.score > b.score;
-            });
+    // --- MICROBENCHMARK: DAAT vs TWO-PHASE ---
+    // Builds random 2/3/5-term AND queries from the most frequent terms (so the
+    // intersections are big), checks both evaluators agree, and prints the mean
+    // latency of each.
+    void runBenchmark(size_t queriesPerSize) {
+        // Most frequent terms by posting list length
+        vector<pair<uint32_t, string>> bySize;
+        for (uint32_t id = 0; id < lexicon.size(); ++id) {
+            uint32_t n = fetchPostings(id).size();
+            if (n > 0) bySize.push_back({n, lexicon.word(id)});
         }
+        sort(bySize.begin(), bySize.end(), [](const pair<uint32_t, string>& a, const pair<uint32_t, string>& b) {
+            return a.first != b.first ? a.first > b.first : a.second < b.second;
+        });
+        if (bySize.size() > 200) bySize.resize(200);
+        if (bySize.size() < 5) { cout << "Benchmark needs at least 5 indexed terms." << endl; return; }
 
-        if (finalRes.size() > 120) finalRes.resize(120);
-        return finalRes;
+        mt19937 rng(42);
+        QueryTimings unused;
+        cout << "terms | queries | two-phase us/q | daat us/q | speedup" << endl;
+        for (size_t numTerms : {2, 3, 5}) {
+            vector<vector<QueryTerm>> workload;
+            while (workload.size() < queriesPerSize) {
+                string q;
+                for (size_t t = 0; t < numTerms; ++t) q += bySize[rng() % bySize.size()].second + " ";
+                vector<QueryTerm> terms;
+                if (prepareQuery(q, terms, unused) && terms.size() == numTerms) workload.push_back(terms);
+            }
+
+            double timeTwoPhase = 0, timeDAAT = 0;
+            size_t mismatches = 0;
+            for (size_t q = 0; q < workload.size(); ++q) {
+                const auto& terms = workload[q];
+                vector<Result> a, b;
+                // Alternate the order so neither side always runs on a warm cache
+                for (int pass = 0; pass < 2; ++pass) {
+                    bool daatTurn = (pass == (int)(q % 2));
+                    auto t0 = chrono::high_resolution_clock::now();
+                    if (daatTurn) evaluateDAAT(terms, QueryFilter(), PositionalPlan(), [&](const Result& r) { b.push_back(r); });
+                    else a = evaluateTwoPhase(terms, QueryFilter());
+                    double us = chrono::duration<double, micro>(chrono::high_resolution_clock::now() - t0).count();
+                    (daatTurn ? timeDAAT : timeTwoPhase) += us;
+                }
+
+                bool same = a.size() == b.size();
+                for (size_t i = 0; same && i < a.size(); ++i) {
+                    same = a[i].docID == b[i].docID && a[i].score == b[i].score;
+                }
+                if (!same) mismatches++;
+            }
+
+            double n = (double)workload.size();
+            cout << numTerms << " | " << workload.size() << " | " << timeTwoPhase / n << " | " << timeDAAT / n
+                 << " | " << (timeDAAT > 0 ? timeTwoPhase / timeDAAT : 0) << "x";
+            if (mismatches) cout << " | MISMATCHES: " << mismatches;
+            cout << endl;
+        }
+    }
+
+    // --- TOP-K WITH BLOCK-MAX PRUNING (conjunctive Block-Max WAND) ---
+    // Walks candidates in docID order. Before touching any posting, the block
+    // directories give an upper bound for the current blocks of all terms:
+    //     sum(idf * block maxTermScore) + PAGERANK_WEIGHT * min(block maxPageRank)
+    // (min, because an AND match sits in every list's block at once).
+    // If that bound can't beat the k-th best score, every doc up to the nearest
+    // block end is skipped without decoding or scoring. Docs are visited in
+    // increasing docID order, so a later doc that only ties the k-th score
+    // loses the tie-break and "<=" is the exact cut: results equal the
+    // exhaustive path. A category moves 'target' to its next member first, so
+    // blocks without an allowed doc are never bounded, decoded or scored.
+    vector<Result> queryTopK(const vector<QueryTerm>& queryTerms, const QueryFilter& filter,
+                             const PositionalPlan& plan, size_t k, QueryTimings& timings) {
+        StageClock clock;
+        vector<PostingCursor> cursors(queryTerms.size());
+        for (size_t i = 0; i < queryTerms.size(); ++i) cursors[i].reset(&queryTerms[i].ref);
+
+        TopK<bool(*)(const Result&, const Result&)> heap(k, rankedBefore);
+
+        uint32_t target = filter.firstDoc;
+        while (true) {
+            if (filter.category) {
+                target = filter.category->nextGEQ(target);
+                if (target == DocFilter::END) break;
+            }
+            if (target >= filter.endDoc) break;
+
+            // 1. Shallow: position every cursor on the block that may hold 'target'
+            bool exhausted = false;
+            for (auto& c : cursors) {
+                if (!c.shallowSeek(target)) { exhausted = true; break; }
+            }
+            if (exhausted) break;
+
+            // 2. Block-max check
+            if (heap.full()) {
+                double bound = 0.0;
+                float minPageRank = cursors[0].blockBound().maxPageRank;
+                for (size_t i = 0; i < cursors.size(); ++i) {
+                    bound += queryTerms[i].idf * cursors[i].blockBound().maxTermScore;
+                    minPageRank = min(minPageRank, cursors[i].blockBound().maxPageRank);
+                }
+                bound += (double)minPageRank * PAGERANK_WEIGHT;
+                if (plan.proximity) bound += PROXIMITY_WEIGHT;
+
+                if (bound <= heap.worst().score) {
+                    uint32_t blockEnd = PostingCursor::END;
+                    for (auto& c : cursors) blockEnd = min(blockEnd, c.blockLastDoc());
+                    if (blockEnd == PostingCursor::END) break;
+                    target = blockEnd + 1;
+                    continue;
+                }
+            }
+
+            // 3. Deep: find the next doc present in every list
+            uint32_t docID = cursors[0].nextGEQ(target);
+            if (docID >= filter.endDoc) break; // END included
+            if (docID != target) { target = docID; continue; } // Re-check bounds for its blocks
+            if (!passesDate(docID, filter)) { target = docID + 1; continue; }
+
+            bool match = true;
+            for (size_t i = 1; i < cursors.size(); ++i) {
+                uint32_t other = cursors[i].nextGEQ(docID);
+                if (other == PostingCursor::END) { exhausted = true; break; }
+                if (other != docID) { target = other; match = false; break; }
+            }
+            if (exhausted) break;
+            if (!match) continue;
+
+            // 4. Score exactly as the exhaustive path does
+            double boost = 0.0;
+            if (!plan.active() || matchPositions(plan, cursors, boost)) {
+                double docScore = boost;
+                for (size_t i = 0; i < cursors.size(); ++i) {
+                    docScore += termScore(queryTerms[i].idf, cursors[i].freq(), docID);
+                }
+                docScore += staticScore(docID);
+
+                heap.push({docID, docScore});
+            }
+            target = docID + 1;
+        }
+        timings.intersect += clock.lap();
+        return takeTimed(heap, timings);
     }
 
     // --- AUTOCOMPLETE: DFS HELPER ---
@@ -447,120 +2277,577 @@ public:
         return results;
     }
 
-    void printDoc(uint32_t docID, double score) {
-        if (docID >= metadata.size()) return;
-        const DocInfo& doc = metadata[docID];
+    void printDoc(uint32_t docID, double score, ostream& out = cout) {
+        if (docID >= metadataDocs) return;
+        DocInfo doc = docInfo(docID);
+        
+        out << "------------------------------------------------" << endl;
+        out << " [" << score << "] " << doc.title << endl;
+        out << "       Authors: " << doc.authors.substr(0, 80) << (doc.authors.size()>80?"...":"") << endl;
+        out << "       Category: " << doc.category << " | Date: " << doc.date << endl;
+        out << "       Link: https://arxiv.org/abs/" << doc.originalID << endl;
+    }
+};
+
+// Parses a non-negative count, returning 'fallback' on junk input
+size_t parseCount(const string& s, size_t fallback) {
+    if (s.empty() || !isdigit((unsigned char)s[0])) return fallback;
+    return (size_t)strtoull(s.c_str(), nullptr, 10);
+}
+
+// --- HOT SWAP ---
+// The loaded index is an immutable snapshot behind a shared_ptr. A swap builds
+// a complete new BarrelSearcher on a background thread and publishes it with
+// one atomic pointer store; queries already running keep their snapshot alive
+// until they finish, and the old one is unmapped when its last query drops it.
+const string SWAP_SIGNAL = "C:\\Users\\Hank47\\Sem3\\Rummager\\swap.signal";
+const int SWAP_POLL_MS = 1000; // Watcher wake-up without inotify (and how soon it sees shutdown)
+
+// Everything a snapshot is built with besides its barrel directory
+struct EngineSettings {
+    bool jsonMode = false;
+    uint32_t docLimit = 0;
+    bool exhaustive = false;
+    size_t postingCacheBytes = 0;
+    size_t resultCacheBytes = 0;
+    long long resultTTL = 0;
+    size_t queryThreads = 1;
+};
+
+shared_ptr<BarrelSearcher> buildSnapshot(const EngineSettings& settings, const string& dir, ostream& log) {
+    auto engine = make_shared<BarrelSearcher>(settings.jsonMode, settings.docLimit, settings.exhaustive, dir, log);
+    engine->setPostingCacheBudget(settings.postingCacheBytes);
+    engine->configureResultCache(settings.resultCacheBytes, settings.resultTTL);
+    engine->setQueryThreads(settings.queryThreads);
+    return engine;
+}
+
+// swap.signal and "/swap" name a directory; the barrels are files inside it
+string barrelDirectory(string dir) {
+    while (!dir.empty() && (dir.back() == ' ' || dir.back() == '\r')) dir.pop_back();
+    if (!dir.empty() && dir.back() != '\\' && dir.back() != '/') dir += (char)fs::path::preferred_separator;
+    return dir;
+}
+
+class LiveIndex {
+private:
+    EngineSettings settings;
+    shared_ptr<BarrelSearcher> live; // Read with atomic_load, replaced with atomic_store
+    uint64_t snapshots = 1;          // Loader thread only (one load at a time)
+
+    mutex loaderLock; // Guards 'loader' and 'loading'
+    thread loader;
+    bool loading = false;
+
+    thread watcher;
+    atomic<bool> stopping{false};
+
+    void load(string dir) {
+        ostringstream log;
+        if (!settings.jsonMode) log << "\n[Hot Swap] Loading " << dir << " in the background..." << endl;
+        // A throw here must not end the process or leave 'loading' set forever
+        try {
+            shared_ptr<BarrelSearcher> next = buildSnapshot(settings, dir, log);
+            if (next->usable()) {
+                next->setSnapshotID(++snapshots);
+                atomic_store(&live, next);
+                if (!settings.jsonMode) log << "[Hot Swap] Snapshot " << snapshots << " is live." << endl;
+            } else if (!settings.jsonMode) {
+                log << "[Hot Swap] " << dir << " has no usable index. Still serving snapshot "
+                    << acquire()->directory() << "." << endl;
+            }
+        } catch (const exception& e) {
+            if (!settings.jsonMode) log << "[Hot Swap] Loading " << dir << " failed (" << e.what()
+                                        << "). Still serving snapshot " << acquire()->directory() << "." << endl;
+        }
+        if (!settings.jsonMode) cerr << log.str() << flush;
+        lock_guard<mutex> guard(loaderLock);
+        loading = false;
+    }
+
+    // Picks up swap.signal if it is there: the first line is the new barrel
+    // directory (empty = reload the current one). False if a load was already
+    // running; the file is left in place and tried again later.
+    bool checkSignal() {
+        error_code ec;
+        if (!fs::exists(SWAP_SIGNAL, ec)) return true;
+        string dir;
+        {
+            ifstream sig(SWAP_SIGNAL);
+            getline(sig, dir);
+        }
+        dir = barrelDirectory(dir);
+        if (!requestSwap(dir.empty() ? acquire()->directory() : dir)) return false;
+        fs::remove(SWAP_SIGNAL, ec);
+        return true;
+    }
+
+#ifdef __linux__
+    // Sleeps in poll() until something is written or renamed into the signal's
+    // directory. False if inotify is unavailable.
+    bool watchInotify() {
+        fs::path signal(SWAP_SIGNAL);
+        string dir = signal.has_parent_path() ? signal.parent_path().string() : ".";
+        int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (fd < 0) return false;
+        if (inotify_add_watch(fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+            ::close(fd);
+            return false;
+        }
+        bool deferred = !checkSignal(); // Written before we started
+        char events[4096];
+        while (!stopping) {
+            pollfd ready = { fd, POLLIN, 0 };
+            bool woken = poll(&ready, 1, SWAP_POLL_MS) > 0;
+            if (woken) while (read(fd, events, sizeof(events)) > 0) {} // Which file doesn't matter, the check does
+            if (woken || deferred) deferred = !checkSignal();
+        }
+        ::close(fd);
+        return true;
+    }
+#endif
+
+    void watch() {
+#ifdef __linux__
+        if (watchInotify()) return;
+#endif
+        while (!stopping) {
+            checkSignal();
+            this_thread::sleep_for(chrono::milliseconds(SWAP_POLL_MS));
+        }
+    }
+
+public:
+    LiveIndex(const EngineSettings& config, const string& dir) : settings(config) {
+        live = buildSnapshot(settings, dir, cout);
+        live->setSnapshotID(snapshots);
+    }
+
+    ~LiveIndex() {
+        stopping = true;
+        if (watcher.joinable()) watcher.join();
+        // load() takes loaderLock on its way out, so join without holding it
+        thread pending;
+        {
+            lock_guard<mutex> guard(loaderLock);
+            pending = move(loader);
+        }
+        if (pending.joinable()) pending.join();
+    }
+
+    LiveIndex(const LiveIndex&) = delete;
+    LiveIndex& operator=(const LiveIndex&) = delete;
+
+    // The snapshot a command runs against; valid for as long as it is held
+    shared_ptr<BarrelSearcher> acquire() const { return atomic_load(&live); }
+
+    // Starts loading 'dir' in the background. False if a load is already running.
+    bool requestSwap(const string& dir) {
+        lock_guard<mutex> guard(loaderLock);
+        if (loading) return false;
+        if (loader.joinable()) loader.join(); // Finished: it cleared 'loading' on its way out
+        loading = true;
+        loader = thread(&LiveIndex::load, this, dir);
+        return true;
+    }
+
+    // Interactive and server modes watch for swap.signal; batch and bench don't
+    void watchSignalFile() {
+        if (!watcher.joinable()) watcher = thread(&LiveIndex::watch, this);
+    }
+};
+
+// One command line (stdin or a server connection), answer written to 'out'
+void handleCommand(LiveIndex& index, const string& input, bool jsonMode, ostream& out) {
+    shared_ptr<BarrelSearcher> snapshot = index.acquire(); // Held until the answer is written
+    BarrelSearcher& engine = *snapshot;
+
+    // --- MEMORY STATS ---
+    if (input == "/stats") {
+        if (jsonMode) engine.printJsonStats(out);
+        else engine.printStats(out);
+        return;
+    }
+
+    // --- CACHE INVALIDATION (after document ingestion) ---
+    if (input == "/flush") {
+        uint64_t generation = engine.invalidateResults();
+        if (jsonMode) out << "{ \"flushed\": true, \"generation\": " << generation << " }" << endl;
+        else out << "Result cache flushed (generation " << generation << ")." << endl;
+        return;
+    }
+
+    // --- HOT SWAP ("/swap [dir]", no dir = reload the current one) ---
+    if (input == "/swap" || input.rfind("/swap ", 0) == 0) {
+        string dir = barrelDirectory(input.size() > 6 ? input.substr(6) : "");
+        if (dir.empty()) dir = engine.directory();
+        bool started = index.requestSwap(dir);
+        if (jsonMode) {
+            out << "{ \"swap\": \"" << (started ? "loading" : "busy") << "\", \"index\": \""
+                << engine.escapeJson(dir) << "\" }" << endl;
+        } else if (started) {
+            out << "Loading " << dir << " in the background; queries keep using the current index." << endl;
+        } else {
+            out << "A swap is already loading. Try again when it is done." << endl;
+        }
+        return;
+    }
+
+    // --- AUTOCOMPLETE ---
+    if (input.rfind("/suggest ", 0) == 0) {
+        string prefix = input.substr(9);
+        auto suggestions = engine.suggest(prefix);
         
-        cout << "------------------------------------------------" << endl;
-        cout << " [" << score << "] " << doc.title << endl;
-        cout << "       Authors: " << doc.authors.substr(0, 80) << (doc.authors.size()>80?"...":"") << endl;
-        cout << "       Category: " << doc.category << " | Date: " << doc.date << endl;
-        cout << "       Link: https://arxiv.org/abs/" << doc.originalID << endl;
+        if (jsonMode) {
+            engine.printJsonSuggestions(suggestions, out);
+        } else {
+            out << "Suggestions: ";
+            for (const auto& s : suggestions) out << s << ", ";
+            out << endl;
+        }
+        return;
+    }
+    QueryOptions opts;
+    string cleanQuery = "";
+    string dateRange = ""; // For the banner only
+
+    // Command Parsing
+    stringstream ss(input);
+    string word;
+    while(ss >> word) {
+        if (word == "/date") {
+            opts.sortByDate = true;
+        } else if (word == "/exhaustive") {
+            opts.exhaustive = true;
+        } else if (word == "/or") {
+            opts.disjunctive = true;
+        } else if (word == "/near") {
+            opts.proximity = true;
+        } else if (word.rfind("/since:", 0) == 0) {
+            if (parseDay(word.substr(7), false, opts.sinceDay)) dateRange += " from " + word.substr(7);
+            else if (!jsonMode) out << "Ignoring bad date: " << word << endl;
+        } else if (word.rfind("/until:", 0) == 0) {
+            if (parseDay(word.substr(7), true, opts.untilDay)) dateRange += " to " + word.substr(7);
+            else if (!jsonMode) out << "Ignoring bad date: " << word << endl;
+        } else if (word.rfind("/cat:", 0) == 0) { 
+            opts.categoryFilter = word.substr(5); 
+        } else if (word.rfind("/offset:", 0) == 0) {
+            opts.offset = min(parseCount(word.substr(8), 0), MAX_OFFSET);
+        } else if (word.rfind("/limit:", 0) == 0) {
+            opts.limit = min(max(parseCount(word.substr(7), DEFAULT_LIMIT), (size_t)1), MAX_LIMIT);
+        } else {
+            cleanQuery += word + " ";
+        }
+    }
+
+    if (cleanQuery.empty()) {
+         if (jsonMode) out << "{ \"results\": [] }" << endl;
+         return;
+    }
+    if (cleanQuery.back() == ' ') cleanQuery.pop_back();
+
+    if (!jsonMode) {
+        out << "Searching for: '" << cleanQuery << "'";
+        if (!opts.categoryFilter.empty()) out << " [Filter: " << opts.categoryFilter << "]";
+        if (!dateRange.empty()) out << " [Dates:" << dateRange << "]";
+        if (opts.sortByDate) out << " [Sorted by Date]";
+        if (opts.disjunctive) out << " [Any Term]";
+        if (opts.proximity) out << " [Proximity]";
+        if (opts.offset > 0) out << " [From #" << opts.offset + 1 << "]";
+        out << "..." << endl;
+    }
+
+    auto start = chrono::high_resolution_clock::now();
+    ResultPage page = engine.query(cleanQuery, opts);
+    auto end = chrono::high_resolution_clock::now();
+    long long duration = chrono::duration_cast<chrono::milliseconds>(end - start).count();
+    
+    if (jsonMode) {
+        engine.printJsonResults(page, opts, duration, out);
+    } else {
+        if (page.positionsMissing) {
+            out << "Note: index has no positions (build with forward_indexer --positions); phrases matched as plain words." << endl;
+        }
+        out << "Found " << page.results.size() << " results in " << duration << "ms"
+             << (page.hasMore ? " (more available, use /offset:N)." : ".") << endl;
+        for (const auto& r : page.results) {
+            engine.printDoc(r.docID, r.score, out);
+        }
+    }
+}
+
+// --- SERVER MODE ---
+const size_t DEFAULT_QUEUE_SIZE = 64;
+const int ACCEPT_POLL_MS = 500; // Accept wait per turn of the loop
+
+// Answers one client's commands in order until it hangs up or sends "exit".
+// Each command runs against the snapshot that was live when it started.
+void serveConnection(LiveIndex& index, socket_t client, bool jsonMode) {
+    Connection conn(client, &serverStopRequested);
+    string line;
+    ostringstream out;
+    while (conn.readLine(line)) {
+        if (line == "exit") break;
+        out.str("");
+        out.clear();
+        handleCommand(index, line, jsonMode, out);
+        if (!conn.writeAll(out.str())) break;
+    }
+}
+
+// Accept loop -> bounded queue -> worker pool, all sharing the live index.
+// Runs until SIGINT / SIGTERM, then drains: no new clients, open connections
+// end after their current command, workers are joined.
+int runServer(LiveIndex& index, const string& address, size_t threads, size_t queueSize, bool jsonMode) {
+    ServerSocket server;
+    if (!server.listenOn(address)) {
+        cerr << "Error: cannot listen on " << address << endl;
+        return 1;
+    }
+
+    BoundedQueue<socket_t> pending(queueSize);
+    vector<thread> workers;
+    for (size_t w = 0; w < threads; ++w) {
+        workers.emplace_back([&] {
+            socket_t client;
+            while (pending.pop(client)) serveConnection(index, client, jsonMode);
+        });
     }
+    if (!jsonMode) cout << "Serving on " << address << " (" << threads << " workers, queue " << queueSize << ")." << endl;
+
+    installStopSignals();
+    index.watchSignalFile();
+    while (!serverStopRequested.load()) {
+        socket_t client = server.acceptFor(ACCEPT_POLL_MS);
+        if (client != NO_SOCKET && !pending.push(client)) closeSocket(client); // Blocks while the queue is full
+    }
+
+    if (!jsonMode) cout << "Shutting down..." << endl;
+    server.close();
+    pending.close(); // Workers finish what is queued (each sees the stop at once) and exit
+    for (thread& t : workers) t.join();
+    return 0;
+}
+
+// --- BATCH MODE (replay / load test) ---
+const size_t BATCH_WINDOW_PER_THREAD = 256; // Queries read ahead / waiting for output, per worker
+
+// One log line on its way through the pipeline
+struct BatchLine {
+    uint64_t seq = 0;
+    string query;
+    string response;
+    double latencyUs = 0;
 };
 
+// Latency at percentile 'p' (nearest rank) of sorted samples
+double percentile(const vector<double>& sorted, double p) {
+    if (sorted.empty()) return 0;
+    size_t rank = (size_t)ceil(p / 100.0 * sorted.size());
+    return sorted[min(max(rank, (size_t)1), sorted.size()) - 1];
+}
+
+// Runs every line of 'inPath' through handleCommand on 'threads' workers and
+// writes one JSONL record per line, in input order:
+//   { "line": N, "query": "...", "latency_us": T, "response": { ...as --json... } }
+// Reader -> workers -> writer (this thread), as in forward_indexer: workers
+// take the next line as soon as they are free, so one slow query never idles
+// the rest, and the writer puts answers back in order. At most 'window' lines
+// are in flight, so memory stays bounded however long the log is.
+// Throughput and p50/p95/p99 go to stderr.
+int runBatch(LiveIndex& index, const string& inPath, const string& outPath, size_t threads) {
+    ifstream in(inPath);
+    if (!in) {
+        cerr << "Error: cannot read " << inPath << endl;
+        return 1;
+    }
+    ofstream outFile;
+    if (!outPath.empty()) {
+        outFile.open(outPath);
+        if (!outFile) {
+            cerr << "Error: cannot write " << outPath << endl;
+            return 1;
+        }
+    }
+    ostream& out = outPath.empty() ? cout : outFile;
+
+    size_t window = threads * BATCH_WINDOW_PER_THREAD;
+    BoundedQueue<BatchLine> toWorkers(window);
+    BoundedQueue<BatchLine> toWriter(window);
+    BoundedQueue<bool> inFlight(window); // One token per line not yet written: caps memory
+    vector<double> latencies; // Microseconds, every query
+    auto batchStart = chrono::steady_clock::now();
+
+    thread reader([&] {
+        string line;
+        for (uint64_t seq = 0;; ++seq) {
+            inFlight.push(true);
+            if (!getline(in, line)) break;
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            BatchLine item;
+            item.seq = seq;
+            item.query = line;
+            toWorkers.push(move(item));
+        }
+        toWorkers.close();
+    });
+
+    vector<thread> workers;
+    for (size_t w = 0; w < threads; ++w) {
+        workers.emplace_back([&] {
+            ostringstream response;
+            BatchLine item;
+            while (toWorkers.pop(item)) {
+                response.str("");
+                auto t0 = chrono::steady_clock::now();
+                handleCommand(index, item.query, true, response);
+                item.latencyUs = chrono::duration<double, micro>(chrono::steady_clock::now() - t0).count();
+                item.response = response.str();
+                toWriter.push(move(item));
+            }
+        });
+    }
+    thread closer([&] {
+        for (thread& t : workers) t.join();
+        toWriter.close();
+    });
+
+    // Lines finish out of order; each is written once all before it are
+    map<uint64_t, BatchLine> waiting;
+    uint64_t nextSeq = 0;
+    BatchLine done;
+    while (toWriter.pop(done)) {
+        uint64_t seq = done.seq;
+        waiting.emplace(seq, move(done));
+        for (auto it = waiting.begin(); it != waiting.end() && it->first == nextSeq; it = waiting.erase(it), ++nextSeq) {
+            BatchLine& item = it->second;
+            string& response = item.response;
+            while (!response.empty() && (response.back() == '\n' || response.back() == '\r')) response.pop_back();
+            out << "{ \"line\": " << nextSeq + 1 << ", \"query\": \"" << index.acquire()->escapeJson(item.query)
+                << "\", \"latency_us\": " << (long long)item.latencyUs
+                << ", \"response\": " << (response.empty() ? "null" : response) << " }\n";
+            latencies.push_back(item.latencyUs);
+
+            bool token;
+            inFlight.pop(token);
+        }
+    }
+    reader.join();
+    closer.join();
+    out.flush();
+
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - batchStart).count();
+    sort(latencies.begin(), latencies.end());
+    double sum = 0;
+    for (double us : latencies) sum += us;
+    size_t n = latencies.size();
+    cerr << "queries | threads | seconds | queries/s | mean ms | p50 ms | p95 ms | p99 ms | max ms" << endl;
+    cerr << n << " | " << threads << " | " << seconds << " | " << (seconds > 0 ? n / seconds : 0)
+         << " | " << (n ? sum / n / 1000 : 0) << " | " << percentile(latencies, 50) / 1000
+         << " | " << percentile(latencies, 95) / 1000 << " | " << percentile(latencies, 99) / 1000
+         << " | " << (n ? latencies.back() / 1000 : 0) << endl;
+    return 0;
+}
+
 int main(int argc, char* argv[]) {
     // --- ARGUMENT PARSING ---
     bool jsonMode = false;
     uint32_t limit = 0;
+    bool exhaustive = false;
+    long long benchQueries = 0;
+    size_t cacheMB = DEFAULT_CACHE_MB; // Posting cache budget, 0 = off
+    size_t resultCacheMB = DEFAULT_RESULT_CACHE_MB; // Result cache budget, 0 = off
+    bool resultCacheSet = false; // --batch turns the cache off unless asked for
+    long long resultTTL = DEFAULT_RESULT_TTL_S;
+    string serveAddress; // "--serve 7070" / "--serve unix:/tmp/rummager.sock"
+    string batchFile, batchOut; // "--batch queries.txt [--out results.jsonl]"
+    size_t threads = max(thread::hardware_concurrency(), 1u);
+    size_t queueSize = DEFAULT_QUEUE_SIZE;
+    size_t queryThreads = 0; // Per query; 0 = all cores interactively, 1 when serving many queries
 
     for (int i = 1; i < argc; i++) {
         string arg = argv[i];
         if (arg == "--json") jsonMode = true;
+        if (arg == "--exhaustive") exhaustive = true;
+        if (arg == "--bench") {
+            benchQueries = (i + 1 < argc && isdigit(argv[i + 1][0])) ? stoll(argv[++i]) : 200;
+        }
+        if (arg == "--simd" && i + 1 < argc) {
+            setSimdLevel(parseSimdLevel(argv[++i]));
+        }
         if (arg == "--limit" && i + 1 < argc) {
             limit = stoi(argv[++i]);
         }
+        if (arg == "--cache-mb" && i + 1 < argc) {
+            cacheMB = parseCount(argv[++i], DEFAULT_CACHE_MB);
+        }
+        if (arg == "--result-cache-mb" && i + 1 < argc) {
+            resultCacheMB = parseCount(argv[++i], DEFAULT_RESULT_CACHE_MB);
+            resultCacheSet = true;
+        }
+        if (arg == "--result-ttl" && i + 1 < argc) {
+            resultTTL = (long long)parseCount(argv[++i], DEFAULT_RESULT_TTL_S);
+        }
+        if (arg == "--batch" && i + 1 < argc) {
+            batchFile = argv[++i];
+            jsonMode = true; // Records embed the --json responses; keeps load messages off stdout
+        }
+        if (arg == "--out" && i + 1 < argc) {
+            batchOut = argv[++i];
+        }
+        if (arg == "--serve" && i + 1 < argc) {
+            serveAddress = argv[++i];
+        }
+        if (arg == "--threads" && i + 1 < argc) {
+            threads = max(parseCount(argv[++i], threads), (size_t)1);
+        }
+        if (arg == "--query-threads" && i + 1 < argc) {
+            queryThreads = max(parseCount(argv[++i], 1), (size_t)1);
+        }
+        if (arg == "--queue" && i + 1 < argc) {
+            queueSize = max(parseCount(argv[++i], DEFAULT_QUEUE_SIZE), (size_t)1);
+        }
     }
 
-    BarrelSearcher engine(jsonMode, limit);
+    // A replayed log repeats queries; cache hits would stand in for engine cost
+    if (!batchFile.empty() && !resultCacheSet) resultCacheMB = 0;
+
+    EngineSettings settings;
+    settings.jsonMode = jsonMode;
+    settings.docLimit = limit;
+    settings.exhaustive = exhaustive;
+    settings.postingCacheBytes = cacheMB * 1024 * 1024;
+    settings.resultCacheBytes = resultCacheMB * 1024 * 1024;
+    settings.resultTTL = resultTTL;
+    // Server and batch already keep every core busy with whole queries
+    if (queryThreads == 0) queryThreads = (batchFile.empty() && serveAddress.empty()) ? max(thread::hardware_concurrency(), 1u) : 1;
+    settings.queryThreads = queryThreads;
+
+    LiveIndex index(settings, BARREL_DIR);
+    if (benchQueries > 0) {
+        index.acquire()->runBenchmark((size_t)benchQueries);
+        return 0;
+    }
+    if (!batchFile.empty()) {
+        return runBatch(index, batchFile, batchOut, threads);
+    }
+    if (!serveAddress.empty()) {
+        return runServer(index, serveAddress, threads, queueSize, jsonMode);
+    }
     string input;
     
     if (!jsonMode) {
         cout << "\n=== arXiv Search Engine ===" << endl;
-        cout << "Options: /suggest <prefix>, /date, /cat:cs.AI" << endl;
+        cout << "Options: /suggest <prefix>, /date, /cat:cs.AI, /since:2022, /until:2023-06, \"a phrase\", /near, /or, /offset:N, /limit:N, /exhaustive, /stats, /swap [dir]" << endl;
     }
 
+    index.watchSignalFile();
     while(true) {
-        // --- HOT SWAP ---
-        if (fs::exists("C:\\Users\\Hank47\\Sem3\\Rummager\\swap.signal")) {
-            if (!jsonMode) cout << "\n[Alignment] HOT SWAP DETECTED!" << endl;
-            
-            ifstream sig("C:\\Users\\Hank47\\Sem3\\Rummager\\swap.signal");
-            string newDir;
-            if (getline(sig, newDir) && !newDir.empty()) {
-                BARREL_DIR = newDir;
-                 if (BARREL_DIR.back() != '\\' && BARREL_DIR.back() != '/') {
-                    BARREL_DIR += "\\";
-                }
-                if (!jsonMode) cout << "Switching Barrels -> " << BARREL_DIR << endl;
-                engine.loadMetadata();
-            }
-            sig.close();
-            fs::remove("C:\\Users\\Hank47\\Sem3\\Rummager\\swap.signal");
-            if (!jsonMode) cout << "Hot Swap Complete." << endl;
-        }
-
         if (!jsonMode) cout << "\nQuery> ";
         if (!getline(cin, input)) break; 
         if (input == "exit") break;
 
-        // --- AUTOCOMPLETE ---
-        if (input.rfind("/suggest ", 0) == 0) {
-            string prefix = input.substr(9);
-            auto suggestions = engine.suggest(prefix);
-            
-            if (jsonMode) {
-                engine.printJsonSuggestions(suggestions);
-            } else {
-                cout << "Suggestions: ";
-                for (const auto& s : suggestions) cout << s << ", ";
-                cout << endl;
-            }
-            continue;
-        }
-        bool sortDate = false;
-        string catFilter = "";
-        string cleanQuery = "";
-
-        // Command Parsing
-        stringstream ss(input);
-        string word;
-        while(ss >> word) {
-            if (word == "/date") {
-                sortDate = true;
-            } else if (word.rfind("/cat:", 0) == 0) { 
-                catFilter = word.substr(5); 
-            } else {
-                cleanQuery += word + " ";
-            }
-        }
-
-        if (cleanQuery.empty()) {
-             if (jsonMode) cout << "{ \"results\": [] }" << endl;
-             continue;
-        }
-        if (cleanQuery.back() == ' ') cleanQuery.pop_back();
-
-        if (!jsonMode) {
-            cout << "Searching for: '" << cleanQuery << "'";
-            if (!catFilter.empty()) cout << " [Filter: " << catFilter << "]";
-            if (sortDate) cout << " [Sorted by Date]";
-            cout << "..." << endl;
-        }
-
-        auto start = chrono::high_resolution_clock::now();
-        auto results = engine.query(cleanQuery, catFilter, sortDate);
-        auto end = chrono::high_resolution_clock::now();
-        long long duration = chrono::duration_cast<chrono::milliseconds>(end - start).count();
-        
-        if (jsonMode) {
-            engine.printJsonResults(results, duration);
-        } else {
-            cout << "Found " << results.size() << " results in " << duration << "ms." << endl;
-            for (const auto& r : results) {
-                engine.printDoc(r.docID, r.score);
-            }
-        }
+        handleCommand(index, input, jsonMode, cout);
     }
     return 0;
 }
@@ -582,10 +2869,90 @@ int main(int argc, char* argv[]) {
        - Final Score = BM25_Score + (PageRank * Weight).
        - BM25 measures "Relevance" (Content).
        - PageRank measures "Authority" (Graph Structure).
+       - Only offset+limit results (default 120) matter, so everything is selected
+         through a bounded heap (O(n log k)), and score-ranked queries use Block-Max WAND:
+         blocks whose best possible score can't make the top-k are skipped unread.
+         "/exhaustive" (or --exhaustive) scores every match, for verification.
     
     3. EFFICIENCY (SEEKING)
        - We do NOT load the entire index into RAM.
-       - We use seekg() (File Pointer) to jump directly to the data we need.
-       - The "Offset Table" in the barrel allows O(1) jump.
-       - This effectively treats the Hard Drive as a giant Hash Map.
+       - Every barrel is memory-mapped once per snapshot (at startup and on hot swap).
+       - The "Offset Table" in the barrel allows O(1) jump to a posting list.
+       - Queries read postings in place through a PostingSpan (no copy, no syscall);
+         the OS page cache decides what is actually resident (see /stats).
+       - v2 barrels are compressed (delta + StreamVByte); blocks are decoded with SIMD
+         only when a query actually needs a posting inside them.
+       - The lexicon (perfect hash) and the paper metadata (doc_metadata.bin, one
+         column per field) are mapped the same way: nothing is parsed at startup,
+         and titles/authors are copied out only for the docs on the printed page.
+
+    4. INTERSECTION
+       - Lists are intersected shortest-first. Live queries move one cursor per
+         term: a galloping search over the v2 block directory (or the v1 list),
+         then a SIMD scan (findGEQ) inside the one decoded block.
+       - The v2 block directory doubles as a skip list, so blocks that can't hold a
+         candidate are jumped over without decoding.
+       - The size-ratio kernel choice (galloping when one list is much longer, SIMD
+         block compare otherwise; intersectAdaptive) only runs in the "--bench"
+         reference below, on v1 lists.
+       - Scoring happens during the intersection (document-at-a-time): one cursor per
+         term, and when all cursors agree on a doc their freqs are right there.
+         "--bench [n]" compares this against the older intersect-then-lookup approach.
+       - The SIMD level (AVX2 / SSE4.1 / scalar) is picked at runtime for the CPU;
+         "--simd scalar" forces the fallback.
+       - "/or" ranks docs matching ANY term instead (term-at-a-time): each list adds
+         its BM25 share into a reused accumulator, dense (array over all docs) for
+         broad queries or sparse (sorted pairs) for selective ones.
+
+    5. PHRASES & PROXIMITY
+       - "quoted words" must appear next to each other; "/near" boosts docs whose
+         query terms sit close together (quoted queries get the boost too).
+       - Positions live in optional barrel_N.pos files and are decoded only for docs
+         that already matched every term, so other queries never read them.
+
+    6. POSTING CACHE
+       - Hot terms' v2 lists are kept fully decoded (byte budget: "--cache-mb N",
+         0 = off), so cursors read their blocks in place instead of decoding again.
+       - TinyLFU admission (a term must be asked for twice) plus segmented LRU
+         eviction: a burst of one-off terms can't flush the hot set.
+       - Hits / misses / evictions are reported by "/stats"; a hot swap empties it.
+       - Whole answers are cached too, keyed on the normalized query (sorted unique
+         tokens, phrases, filters, sort mode). Any page inside the cached top-k is a
+         hit; "--result-cache-mb N" / "--result-ttl S" bound it, and a hot swap or
+         "/flush" (after ingesting documents) starts a new generation.
+
+    7. FILTERS
+       - "/cat:X" is resolved to a docID set from categories.bin (a sorted list or a
+         bitmap per category) and intersected like one more posting list, so docs
+         outside the category are skipped before any scoring.
+       - "/since:" / "/until:" (YYYY, YYYY-MM or YYYY-MM-DD) test the integer date
+         column (doc_dates.bin) per candidate, also before scoring.
+       - "/date" ranks by that column; once the top-k is full, docs older than its
+         last entry are skipped during the intersection.
+
+    8. SERVER MODE
+       - "--serve 7070" (or "unix:/path") answers the same commands over a socket:
+         an accept loop feeds a bounded queue ("--queue N") drained by a worker pool
+         ("--threads N"). A full queue stops accepting, so bursts wait in the backlog.
+       - Workers share the one loaded index; OR accumulators and decoded positions
+         are thread_local, and the mapped lexicon is read-only.
+       - Hot swap ("/swap [dir]", or a directory written to swap.signal, seen via
+         inotify on Linux and a 1s check elsewhere) loads a complete new snapshot on a
+         background thread while queries keep running on the old one, then publishes
+         it with one atomic shared_ptr store. Running queries finish on the snapshot
+         they started with; a failed or empty load is never published.
+       - One broad query can use several cores too ("--query-threads N"): above a
+         cost threshold its docID space is split at block boundaries of the lead
+         list, each range gets its own top-k, and the partial lists are merged.
+         The ranges run on a pool of queryThreads - 1 long-lived helpers (RangePool)
+         so their per-thread scratch, OR accumulators included, is reused.
+       - "--batch queries.txt [--out results.jsonl]" replays a query log on the same
+         workers without a socket: ordered JSONL (response + latency per line), then
+         throughput and p50/p95/p99 on stderr. The standard load test for the engine.
+         Workers pull lines one at a time and the writer reorders them, so a slow
+         query holds up only its own worker. The result cache is off unless
+         "--result-cache-mb N" is given: repeated lines would otherwise time hits.
+       - "--json" answers are built in a reused per-thread buffer (json_writer.h) and
+         written once, and carry tokenize_us / fetch_us / intersect_us / score_us /
+         sort_us: where that query's time went (see QueryTimings).
 */
\ No newline at end of file
@@ -21,7 +21,7 @@ echo OK.
 
 :: 3. COMPILING BACKEND
 echo [3/6] Compiling C++ Core...
-g++ -O3 -std=c++17 searchengine.cpp -o searchengine.exe
+g++ -O3 -std=c++17 searchengine.cpp -o searchengine.exe -lws2_32
 g++ -O3 -std=c++17 trie_builder.cpp -o trie_builder.exe
 :: Assuming add_document.cpp exists or we create a dummy for now
 if exist add_document.cpp g++ -O3 -std=c++17 add_document.cpp -o add_document.exe
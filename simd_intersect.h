@@ -0,0 +1,242 @@
+#ifndef SIMD_INTERSECT_H
+#define SIMD_INTERSECT_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    #define INTERSECT_HAVE_X86_SIMD 1
+    #include <immintrin.h>
+#endif
+
+using namespace std;
+
+// ---------------------------------------------------------
+// SORTED-LIST INTERSECTION KERNELS
+// ---------------------------------------------------------
+// All kernels work on sorted uint32 docIDs read with a STRIDE (in uint32s):
+//   STRIDE 1 = plain docID arrays (decoded blocks, candidate lists)
+//   STRIDE 2 = {docID, freq} postings straight out of a v1 barrel
+// so the mapped barrels never have to be copied into a separate array.
+//
+// Which kernel intersectAdaptive runs is decided at runtime:
+//   - size ratio >= GALLOP_RATIO  -> galloping (exponential) search per candidate
+//   - otherwise                   -> SIMD block compare (Lemire et al., "SIMD
+//                                    Compression and the Intersection of Sorted
+//                                    Integers"), AVX2 or SSE4.1 by CPU support
+//   - no SIMD                     -> scalar two-pointer merge
+//
+// Where each piece is used:
+//   - gallopGEQ / findGEQ: the live query path. searchengine.cpp's PostingCursor
+//     gallops the v2 block directory (or a v1 list) and finds the doc inside the
+//     decoded block with findGEQ. It never looks at the size ratio.
+//   - intersectAdaptive and its kernels: the intersect-then-lookup reference
+//     (evaluateTwoPhase) that "--bench" compares against, for v1 lists only.
+
+enum class SimdLevel { Scalar = 0, SSE41 = 1, AVX2 = 2 };
+
+inline SimdLevel detectSimdLevel() {
+#ifdef INTERSECT_HAVE_X86_SIMD
+    if (__builtin_cpu_supports("avx2")) return SimdLevel::AVX2;
+    if (__builtin_cpu_supports("sse4.1")) return SimdLevel::SSE41;
+#endif
+    return SimdLevel::Scalar;
+}
+
+// Process-wide level. Starts at what the CPU supports; can be lowered
+// (never raised) with setSimdLevel, e.g. to benchmark the scalar path.
+inline SimdLevel& activeSimdLevel() {
+    static SimdLevel level = detectSimdLevel();
+    return level;
+}
+
+inline void setSimdLevel(SimdLevel requested) {
+    SimdLevel supported = detectSimdLevel();
+    activeSimdLevel() = (requested < supported) ? requested : supported;
+}
+
+inline const char* simdLevelName(SimdLevel level) {
+    switch (level) {
+        case SimdLevel::AVX2: return "avx2";
+        case SimdLevel::SSE41: return "sse4.1";
+        default: return "scalar";
+    }
+}
+
+inline SimdLevel parseSimdLevel(const string& name) {
+    if (name == "avx2") return SimdLevel::AVX2;
+    if (name == "sse4" || name == "sse4.1") return SimdLevel::SSE41;
+    return SimdLevel::Scalar;
+}
+
+const size_t GALLOP_RATIO = 32;
+
+// --- SEARCH ---
+
+// First index i in [from, n) with docs[i*S] >= target (n if none).
+// Exponential probe then binary search: O(log distance), not O(log n).
+template<int S>
+inline size_t gallopGEQ(const uint32_t* docs, size_t n, size_t from, uint32_t target) {
+    if (from >= n || docs[from * S] >= target) return from;
+    size_t lo = from;    // docs[lo] < target
+    size_t step = 1;
+    size_t hi = from + step;
+    while (hi < n && docs[hi * S] < target) {
+        lo = hi;
+        step <<= 1;
+        hi = from + step;
+    }
+    if (hi > n) hi = n;
+    // Invariant: docs[lo] < target, and hi == n or docs[hi] >= target
+    while (hi - lo > 1) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (docs[mid * S] < target) lo = mid;
+        else hi = mid;
+    }
+    return hi;
+}
+
+#ifdef INTERSECT_HAVE_X86_SIMD
+__attribute__((target("avx2")))
+inline size_t findGEQ_AVX2(const uint32_t* docs, size_t n, size_t from, uint32_t target) {
+    __m256i t = _mm256_set1_epi32((int)target);
+    while (from + 8 <= n) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(docs + from));
+        __m256i ge = _mm256_cmpeq_epi32(_mm256_max_epu32(x, t), x); // x >= target (unsigned)
+        int mask = _mm256_movemask_ps(_mm256_castsi256_ps(ge));
+        if (mask) return from + __builtin_ctz(mask);
+        from += 8;
+    }
+    while (from < n && docs[from] < target) from++;
+    return from;
+}
+
+__attribute__((target("sse4.1")))
+inline size_t findGEQ_SSE41(const uint32_t* docs, size_t n, size_t from, uint32_t target) {
+    __m128i t = _mm_set1_epi32((int)target);
+    while (from + 4 <= n) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(docs + from));
+        __m128i ge = _mm_cmpeq_epi32(_mm_max_epu32(x, t), x);
+        int mask = _mm_movemask_ps(_mm_castsi128_ps(ge));
+        if (mask) return from + __builtin_ctz(mask);
+        from += 4;
+    }
+    while (from < n && docs[from] < target) from++;
+    return from;
+}
+#endif
+
+// First index in [from, n) of a plain docID array with docs[i] >= target.
+// Used inside decoded blocks (<= 128 entries) where a linear SIMD scan wins.
+inline size_t findGEQ(const uint32_t* docs, size_t n, size_t from, uint32_t target) {
+#ifdef INTERSECT_HAVE_X86_SIMD
+    SimdLevel level = activeSimdLevel();
+    if (level == SimdLevel::AVX2) return findGEQ_AVX2(docs, n, from, target);
+    if (level == SimdLevel::SSE41) return findGEQ_SSE41(docs, n, from, target);
+#endif
+    while (from < n && docs[from] < target) from++;
+    return from;
+}
+
+// --- INTERSECTION ---
+// Each kernel writes the docIDs present in both 'cand' and 'docs' to 'out'
+// and returns how many. 'out' may alias 'cand' (it never runs ahead of it).
+
+template<int S>
+inline size_t intersectMerge(const uint32_t* cand, size_t nc, const uint32_t* docs, size_t nl, uint32_t* out) {
+    size_t i = 0, j = 0, k = 0;
+    while (i < nc && j < nl) {
+        uint32_t a = cand[i], b = docs[j * S];
+        if (a < b) i++;
+        else if (a > b) j++;
+        else { out[k++] = a; i++; j++; }
+    }
+    return k;
+}
+
+template<int S>
+inline size_t intersectGallop(const uint32_t* cand, size_t nc, const uint32_t* docs, size_t nl, uint32_t* out) {
+    size_t j = 0, k = 0;
+    for (size_t i = 0; i < nc && j < nl; ++i) {
+        j = gallopGEQ<S>(docs, nl, j, cand[i]);
+        if (j < nl && docs[j * S] == cand[i]) out[k++] = cand[i];
+    }
+    return k;
+}
+
+#ifdef INTERSECT_HAVE_X86_SIMD
+// Block compare: skip whole blocks of 'docs' whose last element is below the
+// candidate, then test the candidate against the whole block in one compare.
+template<int S>
+__attribute__((target("avx2")))
+inline size_t intersectBlockAVX2(const uint32_t* cand, size_t nc, const uint32_t* docs, size_t nl, uint32_t* out) {
+    const size_t W = 8;
+    size_t i = 0, j = 0, k = 0;
+    while (i < nc) {
+        uint32_t c = cand[i];
+        while (j + W <= nl && docs[(j + W - 1) * S] < c) j += W;
+        if (j + W > nl) {
+            // Fewer than W entries left: finish with the scalar merge
+            return k + intersectMerge<S>(cand + i, nc - i, docs + j * S, nl - j, out + k);
+        }
+
+        __m256i block;
+        if (S == 1) {
+            block = _mm256_loadu_si256((const __m256i*)(docs + j));
+        } else {
+            // 8 {docID,freq} pairs -> 8 docIDs (lane order doesn't matter for equality)
+            __m256 a = _mm256_loadu_ps((const float*)(docs + j * S));
+            __m256 b = _mm256_loadu_ps((const float*)(docs + j * S + 8));
+            block = _mm256_castps_si256(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+        }
+        __m256i eq = _mm256_cmpeq_epi32(block, _mm256_set1_epi32((int)c));
+        if (_mm256_movemask_ps(_mm256_castsi256_ps(eq))) out[k++] = c;
+        i++;
+    }
+    return k;
+}
+
+template<int S>
+__attribute__((target("sse4.1")))
+inline size_t intersectBlockSSE41(const uint32_t* cand, size_t nc, const uint32_t* docs, size_t nl, uint32_t* out) {
+    const size_t W = 4;
+    size_t i = 0, j = 0, k = 0;
+    while (i < nc) {
+        uint32_t c = cand[i];
+        while (j + W <= nl && docs[(j + W - 1) * S] < c) j += W;
+        if (j + W > nl) {
+            return k + intersectMerge<S>(cand + i, nc - i, docs + j * S, nl - j, out + k);
+        }
+
+        __m128i block;
+        if (S == 1) {
+            block = _mm_loadu_si128((const __m128i*)(docs + j));
+        } else {
+            __m128 a = _mm_loadu_ps((const float*)(docs + j * S));
+            __m128 b = _mm_loadu_ps((const float*)(docs + j * S + 4));
+            block = _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+        }
+        __m128i eq = _mm_cmpeq_epi32(block, _mm_set1_epi32((int)c));
+        if (!_mm_testz_si128(eq, eq)) out[k++] = c;
+        i++;
+    }
+    return k;
+}
+#endif
+
+// Picks the kernel from the size ratio and the CPU (see top of file).
+// Reference path only: live queries step PostingCursors instead.
+template<int S>
+inline size_t intersectAdaptive(const uint32_t* cand, size_t nc, const uint32_t* docs, size_t nl, uint32_t* out) {
+    if (nc == 0 || nl == 0) return 0;
+    if (nl / nc >= GALLOP_RATIO) return intersectGallop<S>(cand, nc, docs, nl, out);
+#ifdef INTERSECT_HAVE_X86_SIMD
+    SimdLevel level = activeSimdLevel();
+    if (level == SimdLevel::AVX2) return intersectBlockAVX2<S>(cand, nc, docs, nl, out);
+    if (level == SimdLevel::SSE41) return intersectBlockSSE41<S>(cand, nc, docs, nl, out);
+#endif
+    return intersectMerge<S>(cand, nc, docs, nl, out);
+}
+
+#endif
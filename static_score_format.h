@@ -0,0 +1,203 @@
+#ifndef STATIC_SCORE_FORMAT_H
+#define STATIC_SCORE_FORMAT_H
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <filesystem>
+#include "mapped_file.h"
+
+using namespace std;
+
+// ---------------------------------------------------------
+// STATIC SCORES (static_scores.bin, next to pagerank_scores.txt)
+// ---------------------------------------------------------
+//   [StaticScoreHeader]
+//   STATIC_FLOAT32 : [value: float32 x numDocs]
+//   STATIC_QUANT16 : [q: uint16 x numDocs]        value = q * scale
+//
+// Indexed by docID. value = PageRank * weight: weight 1 is plain PageRank,
+// "page-rank --fold 50" stores the ranking prior (PAGERANK_WEIGHT * PageRank)
+// so the engine adds it as is. 16-bit values are linear steps of max/65535:
+// half the size again, and the step is far below any BM25 difference.
+
+const uint32_t STATIC_MAGIC = 0x53545352; // "RSTS"
+const uint32_t STATIC_VERSION = 1;
+
+const uint32_t STATIC_FLOAT32 = 0;
+const uint32_t STATIC_QUANT16 = 1;
+
+struct StaticScoreHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t numDocs;
+    uint32_t encoding; // STATIC_FLOAT32 or STATIC_QUANT16
+    float scale;       // STATIC_QUANT16 only
+    float weight;      // Folded into every value (1 = plain PageRank)
+};
+
+// --- BUILDING (page-rank, or the readers if only the text file exists) ---
+
+// 'pageRank[d]' = PageRank of doc d. Returns the whole file image.
+inline vector<uint8_t> buildStaticScores(const vector<double>& pageRank, uint32_t encoding = STATIC_FLOAT32,
+                                         float weight = 1.0f) {
+    StaticScoreHeader header = { STATIC_MAGIC, STATIC_VERSION, (uint32_t)pageRank.size(), encoding, 0.0f, weight };
+    size_t width = (encoding == STATIC_QUANT16) ? sizeof(uint16_t) : sizeof(float);
+    vector<uint8_t> out(sizeof(header) + pageRank.size() * width, 0);
+
+    if (encoding == STATIC_QUANT16) {
+        double maxValue = 0;
+        for (double pr : pageRank) maxValue = max(maxValue, pr * weight);
+        header.scale = (maxValue > 0) ? (float)(maxValue / 65535.0) : 1.0f;
+        uint16_t* q = (uint16_t*)(out.data() + sizeof(header));
+        for (size_t d = 0; d < pageRank.size(); ++d) {
+            double steps = pageRank[d] * weight / header.scale;
+            q[d] = (uint16_t)min(65535.0, max(0.0, round(steps)));
+        }
+    } else {
+        float* v = (float*)(out.data() + sizeof(header));
+        for (size_t d = 0; d < pageRank.size(); ++d) v[d] = (float)(pageRank[d] * weight);
+    }
+    memcpy(out.data(), &header, sizeof(header));
+    return out;
+}
+
+// pagerank_scores.txt ("docID score" per line) for docs below 'numDocs'
+inline vector<double> readPageRankText(const string& path, uint32_t numDocs) {
+    vector<double> scores;
+    ifstream in(path);
+    if (!in) return scores;
+    scores.assign(numDocs, 0.0);
+    long long id;
+    double score;
+    while (in >> id >> score) {
+        if (id >= 0 && id < (long long)numDocs) scores[id] = score;
+    }
+    return scores;
+}
+
+// Writes next to 'path' and renames over it, so a reader never maps half a file
+inline bool writeStaticScores(const string& path, const vector<uint8_t>& image) {
+    string tmp = path + ".tmp";
+    {
+        ofstream out(tmp, ios::binary);
+        if (!out) return false;
+        out.write((const char*)image.data(), image.size());
+        if (!out) return false;
+    }
+    error_code ec;
+    std::filesystem::rename(tmp, path, ec);
+    return !ec;
+}
+
+// --- READING (searchengine, create_barrels) ---
+
+class StaticScores {
+private:
+    MappedFile file;
+    vector<uint8_t> image; // Built from the text file when there is no .bin
+    const float* floats = nullptr;
+    const uint16_t* steps = nullptr;
+    uint32_t numDocs = 0;
+    uint32_t kind = STATIC_FLOAT32;
+    float scale = 0.0f;
+    float folded = 1.0f;
+
+    bool attach(const uint8_t* data, size_t size) {
+        if (size < sizeof(StaticScoreHeader)) return false;
+        StaticScoreHeader header;
+        memcpy(&header, data, sizeof(header));
+        if (header.magic != STATIC_MAGIC || header.version != STATIC_VERSION ||
+            header.encoding > STATIC_QUANT16 || !(header.weight > 0.0f)) return false;
+        size_t width = (header.encoding == STATIC_QUANT16) ? sizeof(uint16_t) : sizeof(float);
+        if ((size - sizeof(header)) / width < header.numDocs) return false;
+
+        numDocs = header.numDocs;
+        kind = header.encoding;
+        scale = header.scale;
+        folded = header.weight;
+        if (kind == STATIC_QUANT16) steps = (const uint16_t*)(data + sizeof(header));
+        else floats = (const float*)(data + sizeof(header));
+        return true;
+    }
+
+public:
+    StaticScores() = default;
+    StaticScores(const StaticScores&) = delete;
+    StaticScores& operator=(const StaticScores&) = delete;
+
+    // static_scores.bin if it is there and covers 'minDocs', else the text
+    // file converted in memory (float32, weight 1). False if neither exists.
+    bool load(const string& binPath, const string& textPath, uint32_t minDocs) {
+        close();
+        bool mapped = file.open(binPath) && attach(file.data(), file.size());
+        if (mapped && numDocs >= minDocs) return true;
+        vector<double> pageRank = readPageRankText(textPath, minDocs);
+        if (pageRank.empty()) return mapped; // A short .bin beats nothing: the rest score 0
+        close();
+        image = buildStaticScores(pageRank);
+        return attach(image.data(), image.size());
+    }
+
+    void close() {
+        file.close();
+        image.clear();
+        floats = nullptr;
+        steps = nullptr;
+        numDocs = 0;
+        kind = STATIC_FLOAT32;
+        scale = 0.0f;
+        folded = 1.0f;
+    }
+
+    uint32_t size() const { return numDocs; }
+    bool isMapped() const { return file.isOpen(); }
+    uint32_t encoding() const { return kind; }
+    float weight() const { return folded; }
+    size_t bytes() const { return file.isOpen() ? file.size() : image.size(); }
+
+    // Identifies the values exactly (FNV-1a over encoding, scale, weight and
+    // every stored value). create_barrels records it next to the block bounds;
+    // the engine only prunes with bounds made from the scores it has loaded.
+    uint64_t fingerprint() const {
+        uint64_t h = 1469598103934665603ULL;
+        auto mix = [&h](const void* data, size_t n) {
+            const uint8_t* p = (const uint8_t*)data;
+            for (size_t i = 0; i < n; ++i) h = (h ^ p[i]) * 1099511628211ULL;
+        };
+        mix(&numDocs, sizeof(numDocs));
+        mix(&kind, sizeof(kind));
+        mix(&scale, sizeof(scale));
+        mix(&folded, sizeof(folded));
+        if (steps) mix(steps, (size_t)numDocs * sizeof(uint16_t));
+        if (floats) mix(floats, (size_t)numDocs * sizeof(float));
+        return h;
+    }
+
+    // Stored value (PageRank * weight); 0 for docs the file doesn't cover
+    double value(uint32_t doc) const {
+        if (doc >= numDocs) return 0.0;
+        return steps ? (double)steps[doc] * scale : (double)floats[doc];
+    }
+};
+
+#endif
+
+/*
+    ========================================================================================
+    EDUCATIONAL SUMMARY: STATIC SCORES
+    ========================================================================================
+
+    1. WHY?
+       - pagerank_scores.txt was parsed number by number at every start into a
+         vector<double>: slow, and 8 bytes per doc for a value ranking barely needs.
+       - The binary file is mapped as is: 4 bytes per doc (float32) or 2 (16-bit).
+
+    2. FOLDING THE PRIOR
+       - The engine adds PAGERANK_WEIGHT * PageRank to every score. Storing that
+         product ("--fold") makes the static score one load; weight 1 keeps raw
+         PageRank and the engine multiplies instead.
+*/
@@ -0,0 +1,164 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <unordered_set>
+#include <chrono>
+#include <cctype>
+#include <cstdlib>
+#include "common.h"
+
+using namespace std;
+
+// The stopword set exactly as common.h had it before STOPWORD_LIST. A literal
+// copy, not built from STOPWORD_LIST, so an edit to that list shows up here.
+const unordered_set<string> REFERENCE_STOPWORDS = {
+    "a", "about", "above", "after", "again", "against", "all", "am", "an", "and",
+    "any", "are", "aren't", "as", "at", "be", "because", "been", "before", "being",
+    "below", "between", "both", "but", "by", "can't", "cannot", "could", "couldn't",
+    "did", "didn't", "do", "does", "doesn't", "doing", "don't", "down", "during",
+    "each", "few", "for", "from", "further", "had", "hadn't", "has", "hasn't",
+    "have", "haven't", "having", "he", "he'd", "he'll", "he's", "her", "here",
+    "here's", "hers", "herself", "him", "himself", "his", "how", "how's", "i",
+    "i'd", "i'll", "i'm", "i've", "if", "in", "into", "is", "isn't", "it", "it's",
+    "its", "itself", "let's", "me", "more", "most", "mustn't", "my", "myself",
+    "no", "nor", "not", "of", "off", "on", "once", "only", "or", "other", "ought",
+    "our", "ours", "ourselves", "out", "over", "own", "same", "shan't", "she",
+    "she'd", "she'll", "she's", "should", "shouldn't", "so", "some", "such",
+    "than", "that", "that's", "the", "their", "theirs", "them", "themselves",
+    "then", "there", "there's", "these", "they", "they'd", "they'll", "they're",
+    "they've", "this", "those", "through", "to", "too", "under", "until", "up",
+    "very", "was", "wasn't", "we", "we'd", "we'll", "we're", "we've", "were",
+    "weren't", "what", "what's", "when", "when's", "where", "where's", "which",
+    "while", "who", "who's", "whom", "why", "why's", "with", "won't", "would",
+    "wouldn't", "you", "you'd", "you'll", "you're", "you've", "your", "yours",
+    "yourself", "yourselves"
+};
+
+// The tokenizer as it was before the table-driven one (char-by-char string,
+// a new string per token, unordered_set stopwords). Kept only as the reference
+// the shared Tokenizer must match token for token.
+vector<string> referenceTokenize(const string& text) {
+    const unordered_set<string>& stopwords = REFERENCE_STOPWORDS;
+    vector<string> tokens;
+    string currentToken;
+    tokens.reserve(text.length() / 6);
+
+    for (char c : text) {
+        if (isalnum(c)) {
+            currentToken += tolower(c);
+        } else {
+            if (!currentToken.empty()) {
+                if (stopwords.find(currentToken) == stopwords.end()) {
+                    tokens.push_back(currentToken);
+                }
+                currentToken = "";
+            }
+        }
+    }
+
+    if (!currentToken.empty()) {
+        if (stopwords.find(currentToken) == stopwords.end()) {
+            tokens.push_back(currentToken);
+        }
+    }
+    return tokens;
+}
+
+int main(int argc, char* argv[]) {
+    size_t sampleMB = 64; // "--mb N": how much of clean_dataset.txt to use
+    int rounds = 3;       // "--rounds N": timed passes per tokenizer (best one counts)
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--mb" && i + 1 < argc) sampleMB = (size_t)max(atoi(argv[++i]), 1);
+        if (arg == "--rounds" && i + 1 < argc) rounds = max(atoi(argv[++i]), 1);
+    }
+
+    ifstream file("C:\\Users\\Hank47\\Sem3\\Rummager\\clean_dataset.txt");
+    if (!file.is_open()) {
+        cerr << "Error: Run preprocess.py first!" << endl;
+        return 1;
+    }
+
+    // 1. Sample: the content column of the first N MB, as the indexers see it
+    vector<string> docs;
+    size_t bytes = 0;
+    string line;
+    while (bytes < sampleMB * 1024 * 1024 && getline(file, line)) {
+        size_t tabPos = line.find('\t');
+        if (tabPos == string::npos) continue;
+        docs.push_back(line.substr(tabPos + 1));
+        bytes += docs.back().size();
+    }
+    cout << "Sample: " << docs.size() << " docs, " << bytes / (1024 * 1024) << " MB." << endl;
+
+    // 2. Stopwords: the perfect-hash table must hold exactly the old set. Checked
+    //    word by word, since a sample may never contain the word that differs.
+    size_t mismatches = 0;
+    for (const string& w : REFERENCE_STOPWORDS) {
+        if (!isStopword(w) && mismatches++ == 0) cerr << "Stopword missing from STOPWORD_LIST: " << w << endl;
+    }
+    for (string_view w : STOPWORD_LIST) {
+        if (!REFERENCE_STOPWORDS.count(string(w)) && mismatches++ == 0) cerr << "Stopword not in the original set: " << w << endl;
+    }
+    cout << "Stopword check: " << REFERENCE_STOPWORDS.size() << " words, " << mismatches << " differ." << endl;
+
+    // 3. Differential check: identical tokens, in order, for every doc
+    Tokenizer tokenizer;
+    size_t tokens = 0;
+    size_t docMismatches = 0;
+    for (size_t d = 0; d < docs.size(); ++d) {
+        vector<string> expected = referenceTokenize(docs[d]);
+        const vector<string_view>& got = tokenizer.tokenize(docs[d]);
+        tokens += expected.size();
+        bool same = expected.size() == got.size();
+        for (size_t t = 0; same && t < got.size(); ++t) same = (expected[t] == got[t]);
+        if (!same && docMismatches++ == 0) cerr << "First mismatch in doc " << d << " of the sample." << endl;
+    }
+    cout << "Differential check: " << tokens << " tokens, " << docMismatches << " docs differ." << endl;
+    mismatches += docMismatches;
+
+    // 4. Throughput on one core (best of N passes)
+    volatile size_t sink = 0; // Keeps the passes from being optimized away
+    auto bestMBps = [&](auto&& pass) {
+        double best = 0;
+        for (int r = 0; r < rounds; ++r) {
+            auto start = chrono::steady_clock::now();
+            sink = pass();
+            double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            best = max(best, seconds > 0 ? bytes / (1024.0 * 1024.0) / seconds : 0);
+        }
+        return best;
+    };
+    double reference = bestMBps([&] {
+        size_t n = 0;
+        for (const string& doc : docs) n += referenceTokenize(doc).size();
+        return n;
+    });
+    double tableDriven = bestMBps([&] {
+        size_t n = 0;
+        for (const string& doc : docs) n += tokenizer.tokenize(doc).size();
+        return n;
+    });
+    cout << "tokenizer | MB/s per core" << endl;
+    cout << "reference | " << reference << endl;
+    cout << "table-driven | " << tableDriven << " (" << (reference > 0 ? tableDriven / reference : 0) << "x)" << endl;
+
+    return mismatches == 0 ? 0 : 1;
+}
+
+/*
+    ========================================================================================
+    EDUCATIONAL SUMMARY: TOKENIZER BENCHMARK
+    ========================================================================================
+
+    1. WHY?
+       - The tokenizer decides which words exist at all; a changed token would
+         silently change every lexicon, index and query after it.
+       - So the fast one is checked against the original on real text before its
+         speed is worth anything.
+
+    2. USAGE
+       - "tokenizer_bench [--mb N] [--rounds N]": exit code 1 if any doc or
+         stopword differs.
+*/
@@ -6,6 +6,7 @@
 #include <algorithm>
 #include <filesystem>
 #include <queue>
+#include "lexicon_format.h"
 
 using namespace std;
 
@@ -50,23 +51,12 @@ unordered_map<string, uint32_t> wordFreqs;
 
 void loadLexicon() {
     cout << "Loading Lexicon..." << endl;
-    ifstream file(LEXICON_FILE, ios::binary);
-    if (!file) { cerr << "Error opening " << LEXICON_FILE << endl; exit(1); }
+    LexiconView lexicon;
+    if (!lexicon.open(LEXICON_FILE)) { cerr << "Error opening " << LEXICON_FILE << endl; exit(1); }
 
-    uint32_t totalWords;
-    file.read((char*)&totalWords, sizeof(totalWords));
-    
-    idToWord.resize(totalWords);
-
-    for (uint32_t i = 0; i < totalWords; i++) {
-        uint32_t len;
-        file.read((char*)&len, sizeof(len));
-        string word(len, ' ');
-        file.read(&word[0], len);
-        idToWord[i] = word;
-        // Don't init 0 here, we do it in calc to handle lowercase merging
-    }
-    cout << "Loaded " << totalWords << " words." << endl;
+    // Don't init frequencies here, we do it in calc to handle lowercase merging
+    idToWord = lexicon.words();
+    cout << "Loaded " << idToWord.size() << " words." << endl;
 }
 
 void calculateFrequencies() {